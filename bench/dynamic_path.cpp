@@ -0,0 +1,55 @@
+#include "benchmark/benchmark.h"
+#include "jsontype/Root.hpp"
+#include "jsontype/Dynamic_path.hpp"
+#include <string>
+
+using namespace jsontype;
+
+namespace
+{
+	JSONTYPE_MAKE_TAG(id);
+	JSONTYPE_MAKE_TAG(name);
+	JSONTYPE_MAKE_TAG(contact);
+	JSONTYPE_MAKE_TAG(email);
+	JSONTYPE_MAKE_TAG(address);
+
+	using Person = Root<Value_field<id_tag, unsigned>,
+			Value_field<name_tag, std::string>,
+			Object<contact_tag, Value_field<email_tag, std::string>, Value_field<address_tag, std::string>>>;
+
+	const std::string person_json("{\"id\":1,\"name\":\"Paul\",\"contact\":{\"email\":\"paul@example.com\","
+			"\"address\":\"74 Green St\"}}");
+}
+
+static void path_find(benchmark::State& state)
+{
+	const Person person(person_json);
+	const Dynamic_path<Person> path(std::string("contact.address"));
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(path.find(person));
+	}
+}
+BENCHMARK(path_find);
+
+static void path_find_raw(benchmark::State& state)
+{
+	const Person person(person_json);
+	const std::string contact("contact");
+	const std::string address("address");
+	for (auto _ : state)
+	{
+		const auto& doc = person.ref();
+		const auto member = doc.FindMember(contact);
+		const rapidjson::Value* node = nullptr;
+		if (member != doc.MemberEnd())
+		{
+			const auto leaf = member->value.FindMember(address);
+			node = leaf != member->value.MemberEnd() ? &leaf->value : nullptr;
+		}
+		benchmark::DoNotOptimize(node);
+	}
+}
+BENCHMARK(path_find_raw);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,67 @@
+#include "benchmark/benchmark.h"
+#include "jsontype/Root.hpp"
+#include "jsontype/Inline_root.hpp"
+#include <string>
+
+using namespace jsontype;
+
+namespace
+{
+	JSONTYPE_MAKE_TAG(name);
+	JSONTYPE_MAKE_TAG(age);
+	JSONTYPE_MAKE_TAG(height);
+	JSONTYPE_MAKE_TAG(active);
+
+	using Payload_name = Value_field<name_tag, std::string>;
+	using Payload_age = Value_field<age_tag, unsigned>;
+	using Payload_height = Value_field<height_tag, double>;
+	using Payload_active = Value_field<active_tag, bool>;
+	using Person = Root<Payload_name, Payload_age, Payload_height, Payload_active>;
+	using Inline_person = Inline_root<Payload_name, Payload_age, Payload_height, Payload_active>;
+}
+
+template <typename Person_type>
+static void construct_and_fill(benchmark::State& state)
+{
+	for (auto _ : state)
+	{
+		Person_type person;
+		person[name_tag{}] = "Paul";
+		person[age_tag{}] = 20;
+		person[height_tag{}] = 1.8;
+		person[active_tag{}] = true;
+		benchmark::DoNotOptimize(person);
+	}
+}
+BENCHMARK_TEMPLATE(construct_and_fill, Inline_person);
+BENCHMARK_TEMPLATE(construct_and_fill, Person);
+
+template <typename Person_type>
+static void get_set(benchmark::State& state)
+{
+	Person_type person;
+	for (auto _ : state)
+	{
+		const unsigned age = person[age_tag{}];
+		person[age_tag{}] = age + 1;
+	}
+	benchmark::DoNotOptimize(person);
+}
+BENCHMARK_TEMPLATE(get_set, Inline_person);
+BENCHMARK_TEMPLATE(get_set, Person);
+
+template <typename Person_type>
+static void fill_and_stringify(benchmark::State& state)
+{
+	for (auto _ : state)
+	{
+		Person_type person;
+		person[name_tag{}] = "Paul";
+		person[age_tag{}] = 20;
+		benchmark::DoNotOptimize(person.stringify());
+	}
+}
+BENCHMARK_TEMPLATE(fill_and_stringify, Inline_person);
+BENCHMARK_TEMPLATE(fill_and_stringify, Person);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,56 @@
+#include "benchmark/benchmark.h"
+#include "jsontype/Root.hpp"
+#include "jsontype/Projection.hpp"
+#include <string>
+
+using namespace jsontype;
+
+namespace
+{
+	JSONTYPE_MAKE_TAG(id);
+	JSONTYPE_MAKE_TAG(name);
+	JSONTYPE_MAKE_TAG(contact);
+	JSONTYPE_MAKE_TAG(email);
+
+	using Person = Root<Value_field<id_tag, unsigned>,
+			Value_field<name_tag, std::string>,
+			Object<contact_tag, Value_field<email_tag, std::string>>>;
+
+	// A few declared members buried in a large amount of undeclared ones
+	std::string make_json()
+	{
+		std::string json("{\"id\":1,\"history\":[");
+		for (int i = 0; i < 200; ++i)
+		{
+			json += (i ? "," : "");
+			json += "{\"at\":" + std::to_string(1500000000 + i) + ",\"amount\":" + std::to_string(i * 1.25)
+					+ ",\"note\":\"payment \\\"" + std::to_string(i) + "\\\" received\",\"tags\":[\"a\",\"b\"]}";
+		}
+		json += "],\"name\":\"Paul\",\"contact\":{\"email\":\"paul@example.com\",\"fax\":null}}";
+		return json;
+	}
+
+	const std::string person_json = make_json();
+}
+
+static void project_person(benchmark::State& state)
+{
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(project<Person>(person_json));
+	}
+}
+BENCHMARK(project_person);
+
+static void project_person_raw(benchmark::State& state)
+{
+	for (auto _ : state)
+	{
+		rapidjson::Document doc;
+		doc.Parse(person_json);
+		benchmark::DoNotOptimize(doc);
+	}
+}
+BENCHMARK(project_person_raw);
+
+BENCHMARK_MAIN();
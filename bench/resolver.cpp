@@ -0,0 +1,201 @@
+#include "benchmark/benchmark.h"
+#include "jsontype/Resolver.hpp"
+#include "jsontype/Key.hpp"
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+using namespace jsontype;
+
+namespace
+{
+	constexpr const char* field_names[] = {
+		"f00", "f01", "f02", "f03", "f04", "f05", "f06", "f07", "f08", "f09", "f10", "f11", "f12", "f13", "f14", "f15",
+		"f16", "f17", "f18", "f19", "f20", "f21", "f22", "f23", "f24", "f25", "f26", "f27", "f28", "f29", "f30", "f31",
+		"f32", "f33", "f34", "f35", "f36", "f37", "f38", "f39", "f40", "f41", "f42", "f43", "f44", "f45", "f46", "f47",
+		"f48", "f49", "f50", "f51", "f52", "f53", "f54", "f55", "f56", "f57", "f58", "f59", "f60", "f61", "f62", "f63"
+	};
+
+	template <std::size_t N>
+	struct Field_tag : Tag<Field_tag<N>> { static constexpr auto name() { return field_names[N]; } };
+
+	JSONTYPE_MAKE_TAG(leaf);
+	JSONTYPE_MAKE_TAG(type);
+
+	int handler(int value) { return value + 1; }
+
+	template <std::size_t... I>
+	void add_keys(Resolver<int(*)(int)>& resolver, std::index_sequence<I...>)
+	{
+		const int expand[] = { (resolver.add(Key<Field_tag<I>, leaf_tag>{}, handler), 0)... };
+		(void)expand;
+	}
+
+	template <std::size_t Keys>
+	Resolver<int(*)(int)> make_resolver()
+	{
+		Resolver<int(*)(int)> resolver;
+		add_keys(resolver, std::make_index_sequence<Keys>{});
+		return resolver;
+	}
+
+	template <std::size_t... I>
+	void add_value_keys(Resolver<int(*)(int)>& resolver, std::index_sequence<I...>)
+	{
+		const int expand[] = { (resolver.add(Key<Value_match<type_tag, Field_tag<I>>>{}, handler), 0)... };
+		(void)expand;
+	}
+
+	template <std::size_t Keys>
+	Resolver<int(*)(int)> make_value_resolver()
+	{
+		Resolver<int(*)(int)> resolver;
+		add_value_keys(resolver, std::make_index_sequence<Keys>{});
+		return resolver;
+	}
+
+	template <std::size_t Keys>
+	std::unordered_map<std::string, int(*)(int)> make_handlers()
+	{
+		std::unordered_map<std::string, int(*)(int)> handlers;
+		for (std::size_t i = 0; i < Keys; ++i)
+		{
+			handlers.emplace(field_names[i], handler);
+		}
+		return handlers;
+	}
+
+	// Document with width - 1 members unknown to the resolver followed by the member matching the first key
+	std::string make_json(int width)
+	{
+		std::string json("{");
+		for (int i = 1; i < width; ++i)
+		{
+			json += "\"x" + std::to_string(i) + "\":{\"leaf\":0},";
+		}
+		return json + "\"f00\":{\"leaf\":0}}";
+	}
+}
+
+template <std::size_t Keys>
+static void scan(benchmark::State& state)
+{
+	const auto resolver = make_resolver<Keys>();
+	rapidjson::Document doc;
+	doc.Parse(make_json(static_cast<int>(state.range(0))));
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(resolver.scan(doc, 1));
+	}
+}
+BENCHMARK_TEMPLATE(scan, 4)->Arg(1)->Arg(16)->Arg(128);
+BENCHMARK_TEMPLATE(scan, 16)->Arg(1)->Arg(16)->Arg(128);
+BENCHMARK_TEMPLATE(scan, 64)->Arg(1)->Arg(16)->Arg(128);
+
+template <std::size_t Keys>
+static void scan_raw(benchmark::State& state)
+{
+	const auto handlers = make_handlers<Keys>();
+	rapidjson::Document doc;
+	doc.Parse(make_json(static_cast<int>(state.range(0))));
+	for (auto _ : state)
+	{
+		int result = 0;
+		for (const auto& member : doc.GetObject())
+		{
+			const auto it = handlers.find(member.name.GetString());
+			if (it != handlers.cend() && member.value.IsObject() && member.value.HasMember("leaf"))
+			{
+				result = it->second(1);
+				break;
+			}
+		}
+		benchmark::DoNotOptimize(result);
+	}
+}
+BENCHMARK_TEMPLATE(scan_raw, 4)->Arg(1)->Arg(16)->Arg(128);
+BENCHMARK_TEMPLATE(scan_raw, 16)->Arg(1)->Arg(16)->Arg(128);
+BENCHMARK_TEMPLATE(scan_raw, 64)->Arg(1)->Arg(16)->Arg(128);
+
+// Message type given by the value of a member, with the last type declared matching
+template <std::size_t Keys>
+static void scan_value(benchmark::State& state)
+{
+	const auto resolver = make_value_resolver<Keys>();
+	rapidjson::Document doc;
+	doc.Parse(std::string("{\"id\":1,\"type\":\"") + field_names[Keys - 1] + "\",\"payload\":{}}");
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(resolver.scan(doc, 1));
+	}
+}
+BENCHMARK_TEMPLATE(scan_value, 4);
+BENCHMARK_TEMPLATE(scan_value, 64);
+
+template <std::size_t Keys>
+static void scan_value_raw(benchmark::State& state)
+{
+	const auto handlers = make_handlers<Keys>();
+	rapidjson::Document doc;
+	doc.Parse(std::string("{\"id\":1,\"type\":\"") + field_names[Keys - 1] + "\",\"payload\":{}}");
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(handlers.at(doc["type"].GetString())(1));
+	}
+}
+BENCHMARK_TEMPLATE(scan_value_raw, 4);
+BENCHMARK_TEMPLATE(scan_value_raw, 64);
+
+template <std::size_t Keys>
+static void invoke(benchmark::State& state)
+{
+	const auto resolver = make_resolver<Keys>();
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(resolver.invoke(Key<Field_tag<Keys - 1>, leaf_tag>{}, 1));
+	}
+}
+BENCHMARK_TEMPLATE(invoke, 4);
+BENCHMARK_TEMPLATE(invoke, 16);
+BENCHMARK_TEMPLATE(invoke, 64);
+
+template <std::size_t Keys>
+static void invoke_raw(benchmark::State& state)
+{
+	const auto handlers = make_handlers<Keys>();
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(handlers.at(field_names[Keys - 1])(1));
+	}
+}
+BENCHMARK_TEMPLATE(invoke_raw, 4);
+BENCHMARK_TEMPLATE(invoke_raw, 16);
+BENCHMARK_TEMPLATE(invoke_raw, 64);
+
+template <std::size_t Keys>
+static void handle(benchmark::State& state)
+{
+	const auto resolver = make_resolver<Keys>();
+	const auto handle = resolver.handle(Key<Field_tag<Keys - 1>, leaf_tag>{});
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(handle(1));
+	}
+}
+BENCHMARK_TEMPLATE(handle, 4);
+BENCHMARK_TEMPLATE(handle, 64);
+
+template <std::size_t Keys>
+static void handle_raw(benchmark::State& state)
+{
+	const auto handlers = make_handlers<Keys>();
+	const auto function = handlers.at(field_names[Keys - 1]);
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(function(1));
+	}
+}
+BENCHMARK_TEMPLATE(handle_raw, 4);
+BENCHMARK_TEMPLATE(handle_raw, 64);
+
+BENCHMARK_MAIN();
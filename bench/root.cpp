@@ -0,0 +1,488 @@
+#include "benchmark/benchmark.h"
+#include "jsontype/Root.hpp"
+#include "jsontype/Key.hpp"
+#include "jsontype/Thread_cache_allocator.hpp"
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+using namespace jsontype;
+
+namespace
+{
+	JSONTYPE_MAKE_TAG(name);
+	JSONTYPE_MAKE_TAG(age);
+	JSONTYPE_MAKE_TAG(contact);
+	JSONTYPE_MAKE_TAG(address);
+	JSONTYPE_MAKE_TAG(phone);
+	JSONTYPE_MAKE_TAG(geo);
+	JSONTYPE_MAKE_TAG(lat);
+	JSONTYPE_MAKE_TAG(tags);
+	JSONTYPE_MAKE_TAG(val);
+	JSONTYPE_MAKE_TAG(people);
+
+	using Person = Root<Value_field<name_tag, std::string>,
+			Value_field<age_tag, unsigned>,
+			Object<contact_tag,
+					Value_field<address_tag, std::string>,
+					Value_field<phone_tag, std::string>,
+					Object<geo_tag, Value_field<lat_tag, double>>>,
+			Array<tags_tag>>;
+
+	using lat_key = Key<contact_tag, geo_tag, lat_tag>;
+
+	const std::string person_json("{\"name\":\"Paul\",\"age\":20,\"contact\":{\"address\":\"74 Green St\","
+			"\"phone\":\"564565132\",\"geo\":{\"lat\":45.5}},\"tags\":[\"a\",\"b\"]}");
+
+	void build_raw(rapidjson::Document& doc)
+	{
+		auto& alloc = doc.GetAllocator();
+		doc.SetObject();
+		doc.AddMember("name", rapidjson::Value(rapidjson::kStringType), alloc);
+		doc.AddMember("age", 0u, alloc);
+		rapidjson::Value geo(rapidjson::kObjectType);
+		geo.AddMember("lat", 0.0, alloc);
+		rapidjson::Value contact(rapidjson::kObjectType);
+		contact.AddMember("address", rapidjson::Value(rapidjson::kStringType), alloc);
+		contact.AddMember("phone", rapidjson::Value(rapidjson::kStringType), alloc);
+		contact.AddMember("geo", geo, alloc);
+		doc.AddMember("contact", contact, alloc);
+		doc.AddMember("tags", rapidjson::Value(rapidjson::kArrayType), alloc);
+	}
+
+	template <typename Document>
+	bool check_raw(const Document& doc)
+	{
+		if (!doc.IsObject())
+		{
+			return false;
+		}
+		const auto name = doc.FindMember("name");
+		const auto age = doc.FindMember("age");
+		const auto contact = doc.FindMember("contact");
+		const auto tags = doc.FindMember("tags");
+		if (name == doc.MemberEnd() || !name->value.IsString() || age == doc.MemberEnd() || !age->value.IsUint()
+				|| contact == doc.MemberEnd() || !contact->value.IsObject() || tags == doc.MemberEnd()
+				|| !tags->value.IsArray())
+		{
+			return false;
+		}
+		const auto& c = contact->value;
+		const auto address = c.FindMember("address");
+		const auto phone = c.FindMember("phone");
+		const auto geo = c.FindMember("geo");
+		if (address == c.MemberEnd() || !address->value.IsString() || phone == c.MemberEnd()
+				|| !phone->value.IsString() || geo == c.MemberEnd() || !geo->value.IsObject())
+		{
+			return false;
+		}
+		const auto lat = geo->value.FindMember("lat");
+		return lat != geo->value.MemberEnd() && lat->value.IsDouble();
+	}
+
+	template <typename T> struct Sample;
+	template <> struct Sample<bool> { static bool value() { return true; } };
+	template <> struct Sample<int> { static int value() { return -42; } };
+	template <> struct Sample<unsigned> { static unsigned value() { return 42u; } };
+	template <> struct Sample<int64_t> { static int64_t value() { return -9999999999; } };
+	template <> struct Sample<uint64_t> { static uint64_t value() { return 9999999999u; } };
+	template <> struct Sample<float> { static float value() { return 5.5f; } };
+	template <> struct Sample<double> { static double value() { return 6.25; } };
+	template <> struct Sample<std::string> { static std::string value() { return "a value long enough to skip sso"; } };
+	template <> struct Sample<const char*> { static const char* value() { return "a value long enough to skip sso"; } };
+
+	std::string people_json(std::size_t count)
+	{
+		std::string json = "{\"people\":[";
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			json += i == 0 ? "" : ",";
+			json += "{\"name\":\"Paul\",\"age\":20,\"geo\":{\"lat\":45.5}}";
+		}
+		return json + "]}";
+	}
+}
+
+static void construct_default(benchmark::State& state)
+{
+	for (auto _ : state)
+	{
+		Person person;
+		benchmark::DoNotOptimize(person);
+	}
+}
+BENCHMARK(construct_default);
+
+static void construct_default_raw(benchmark::State& state)
+{
+	for (auto _ : state)
+	{
+		rapidjson::Document doc;
+		build_raw(doc);
+		benchmark::DoNotOptimize(doc);
+	}
+}
+BENCHMARK(construct_default_raw);
+
+static void parse_and_check(benchmark::State& state)
+{
+	for (auto _ : state)
+	{
+		Person person(person_json);
+		benchmark::DoNotOptimize(person);
+	}
+}
+BENCHMARK(parse_and_check);
+
+static void parse_and_check_raw(benchmark::State& state)
+{
+	for (auto _ : state)
+	{
+		rapidjson::Document doc;
+		doc.Parse(person_json);
+		benchmark::DoNotOptimize(check_raw(doc));
+	}
+}
+BENCHMARK(parse_and_check_raw);
+
+static void parse_interned(benchmark::State& state)
+{
+	using Interned_person = Generic_root<Interned_document<rapidjson::Document>,
+			Value_field<name_tag, std::string>,
+			Value_field<age_tag, unsigned>,
+			Object<contact_tag,
+					Value_field<address_tag, std::string>,
+					Value_field<phone_tag, std::string>,
+					Object<geo_tag, Value_field<lat_tag, double>>>,
+			Array<tags_tag>>;
+	for (auto _ : state)
+	{
+		Interned_person person(person_json);
+		benchmark::DoNotOptimize(person);
+	}
+}
+BENCHMARK(parse_interned);
+
+static void parse_thread_cached(benchmark::State& state)
+{
+	using Cached_person = Thread_cached_root<Value_field<name_tag, std::string>,
+			Value_field<age_tag, unsigned>,
+			Object<contact_tag,
+					Value_field<address_tag, std::string>,
+					Value_field<phone_tag, std::string>,
+					Object<geo_tag, Value_field<lat_tag, double>>>,
+			Array<tags_tag>>;
+	for (auto _ : state)
+	{
+		Cached_person person(person_json);
+		benchmark::DoNotOptimize(person);
+	}
+}
+BENCHMARK(parse_thread_cached);
+
+static void parse_thread_cached_raw(benchmark::State& state)
+{
+	for (auto _ : state)
+	{
+		Thread_cached_document doc;
+		doc.Parse(person_json);
+		benchmark::DoNotOptimize(check_raw(doc));
+	}
+}
+BENCHMARK(parse_thread_cached_raw);
+
+static void clone(benchmark::State& state)
+{
+	const Person person(person_json);
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(person.clone());
+	}
+}
+BENCHMARK(clone);
+
+static void clone_raw(benchmark::State& state)
+{
+	rapidjson::Document doc;
+	doc.Parse(person_json);
+	for (auto _ : state)
+	{
+		rapidjson::Document copy;
+		copy.CopyFrom(doc, copy.GetAllocator());
+		benchmark::DoNotOptimize(copy);
+	}
+}
+BENCHMARK(clone_raw);
+
+static void equal(benchmark::State& state)
+{
+	const Person first(person_json);
+	const Person second(person_json);
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(first == second);
+	}
+}
+BENCHMARK(equal);
+
+static void equal_raw(benchmark::State& state)
+{
+	const Person first(person_json);
+	const Person second(person_json);
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(first.stringify() == second.stringify());
+	}
+}
+BENCHMARK(equal_raw);
+
+static void hash_root(benchmark::State& state)
+{
+	const Person person(person_json);
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(hash(person));
+	}
+}
+BENCHMARK(hash_root);
+
+static void hash_root_raw(benchmark::State& state)
+{
+	const Person person(person_json);
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(std::hash<std::string>()(person.stringify()));
+	}
+}
+BENCHMARK(hash_root_raw);
+
+static void find_tag(benchmark::State& state)
+{
+	const Person person(person_json);
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(person[age_tag{}].get());
+	}
+}
+BENCHMARK(find_tag);
+
+static void find_tag_raw(benchmark::State& state)
+{
+	rapidjson::Document doc;
+	doc.Parse(person_json);
+	const auto& ref = doc;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(ref["age"].GetUint());
+	}
+}
+BENCHMARK(find_tag_raw);
+
+static void find_key(benchmark::State& state)
+{
+	const Person person(person_json);
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(person[lat_key{}].get());
+	}
+}
+BENCHMARK(find_key);
+
+static void find_key_raw(benchmark::State& state)
+{
+	rapidjson::Document doc;
+	doc.Parse(person_json);
+	const auto& ref = doc;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(ref["contact"]["geo"]["lat"].GetDouble());
+	}
+}
+BENCHMARK(find_key_raw);
+
+// Compared with find_key and find_key_raw, it shows what the phase timers cost
+static void find_key_timed(benchmark::State& state)
+{
+	using Timed_person = Timed_root<Value_field<name_tag, std::string>,
+			Value_field<age_tag, unsigned>,
+			Object<contact_tag,
+					Value_field<address_tag, std::string>,
+					Value_field<phone_tag, std::string>,
+					Object<geo_tag, Value_field<lat_tag, double>>>,
+			Array<tags_tag>>;
+	const Timed_person person(person_json);
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(person[lat_key{}].get());
+	}
+}
+BENCHMARK(find_key_timed);
+
+template <typename T>
+static void get_value(benchmark::State& state)
+{
+	Root<Value_field<val_tag, T>> root;
+	root[val_tag{}] = Sample<T>::value();
+	const auto& ref = root;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(ref[val_tag{}].get());
+	}
+}
+BENCHMARK_TEMPLATE(get_value, bool);
+BENCHMARK_TEMPLATE(get_value, int);
+BENCHMARK_TEMPLATE(get_value, unsigned);
+BENCHMARK_TEMPLATE(get_value, int64_t);
+BENCHMARK_TEMPLATE(get_value, uint64_t);
+BENCHMARK_TEMPLATE(get_value, float);
+BENCHMARK_TEMPLATE(get_value, double);
+BENCHMARK_TEMPLATE(get_value, std::string);
+BENCHMARK_TEMPLATE(get_value, const char*);
+
+template <typename T>
+static void get_value_raw(benchmark::State& state)
+{
+	rapidjson::Document doc(rapidjson::kObjectType);
+	rapidjson::Value value;
+	detail::Value_traits<T>::set(value, doc.GetAllocator(), Sample<T>::value());
+	doc.AddMember("val", value, doc.GetAllocator());
+	const auto& ref = doc;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(detail::Value_traits<T>::get(ref["val"]));
+	}
+}
+BENCHMARK_TEMPLATE(get_value_raw, bool);
+BENCHMARK_TEMPLATE(get_value_raw, int);
+BENCHMARK_TEMPLATE(get_value_raw, unsigned);
+BENCHMARK_TEMPLATE(get_value_raw, int64_t);
+BENCHMARK_TEMPLATE(get_value_raw, uint64_t);
+BENCHMARK_TEMPLATE(get_value_raw, float);
+BENCHMARK_TEMPLATE(get_value_raw, double);
+BENCHMARK_TEMPLATE(get_value_raw, std::string);
+BENCHMARK_TEMPLATE(get_value_raw, const char*);
+
+template <typename T>
+static void set_value(benchmark::State& state)
+{
+	Root<Value_field<val_tag, T>> root;
+	const T value = Sample<T>::value();
+	for (auto _ : state)
+	{
+		root[val_tag{}] = value;
+	}
+}
+BENCHMARK_TEMPLATE(set_value, bool);
+BENCHMARK_TEMPLATE(set_value, int);
+BENCHMARK_TEMPLATE(set_value, unsigned);
+BENCHMARK_TEMPLATE(set_value, int64_t);
+BENCHMARK_TEMPLATE(set_value, uint64_t);
+BENCHMARK_TEMPLATE(set_value, float);
+BENCHMARK_TEMPLATE(set_value, double);
+BENCHMARK_TEMPLATE(set_value, std::string);
+BENCHMARK_TEMPLATE(set_value, const char*);
+
+template <typename T>
+static void set_value_raw(benchmark::State& state)
+{
+	rapidjson::Document doc(rapidjson::kObjectType);
+	rapidjson::Value value;
+	detail::Value_traits<T>::set(value, doc.GetAllocator(), Sample<T>::value());
+	doc.AddMember("val", value, doc.GetAllocator());
+	const T sample = Sample<T>::value();
+	for (auto _ : state)
+	{
+		detail::Value_traits<T>::set(doc["val"], doc.GetAllocator(), sample);
+	}
+}
+BENCHMARK_TEMPLATE(set_value_raw, bool);
+BENCHMARK_TEMPLATE(set_value_raw, int);
+BENCHMARK_TEMPLATE(set_value_raw, unsigned);
+BENCHMARK_TEMPLATE(set_value_raw, int64_t);
+BENCHMARK_TEMPLATE(set_value_raw, uint64_t);
+BENCHMARK_TEMPLATE(set_value_raw, float);
+BENCHMARK_TEMPLATE(set_value_raw, double);
+BENCHMARK_TEMPLATE(set_value_raw, std::string);
+BENCHMARK_TEMPLATE(set_value_raw, const char*);
+
+static void check_typed_array(benchmark::State& state)
+{
+	using People = Root<Array<people_tag,
+			Object<tags_tag,
+					Value_field<name_tag, std::string>,
+					Value_field<age_tag, unsigned>,
+					Object<geo_tag, Value_field<lat_tag, double>>>>>;
+	rapidjson::Document source;
+	source.Parse(people_json(static_cast<std::size_t>(state.range(0))));
+	for (auto _ : state)
+	{
+		state.PauseTiming();
+		rapidjson::Document doc;
+		doc.CopyFrom(source, doc.GetAllocator());
+		state.ResumeTiming();
+		benchmark::DoNotOptimize(People(std::move(doc)));
+	}
+}
+BENCHMARK(check_typed_array)->Arg(1000)->Arg(100000);
+
+static void check_typed_array_raw(benchmark::State& state)
+{
+	rapidjson::Document doc;
+	doc.Parse(people_json(static_cast<std::size_t>(state.range(0))));
+	for (auto _ : state)
+	{
+		bool valid = true;
+		for (const auto& element : doc["people"].GetArray())
+		{
+			if (!element.IsObject())
+			{
+				valid = false;
+				break;
+			}
+			const auto name = element.FindMember("name");
+			const auto age = element.FindMember("age");
+			const auto geo = element.FindMember("geo");
+			if (name == element.MemberEnd() || !name->value.IsString() || age == element.MemberEnd()
+					|| !age->value.IsUint() || geo == element.MemberEnd() || !geo->value.IsObject())
+			{
+				valid = false;
+				break;
+			}
+			const auto lat = geo->value.FindMember("lat");
+			valid = lat != geo->value.MemberEnd() && lat->value.IsDouble();
+			if (!valid)
+			{
+				break;
+			}
+		}
+		benchmark::DoNotOptimize(valid);
+	}
+}
+BENCHMARK(check_typed_array_raw)->Arg(1000)->Arg(100000);
+
+static void stringify(benchmark::State& state)
+{
+	const Person person(person_json);
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(person.stringify());
+	}
+}
+BENCHMARK(stringify);
+
+static void stringify_raw(benchmark::State& state)
+{
+	rapidjson::Document doc;
+	doc.Parse(person_json);
+	for (auto _ : state)
+	{
+		rapidjson::StringBuffer buffer;
+		rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+		doc.Accept(writer);
+		benchmark::DoNotOptimize(std::string(buffer.GetString()));
+	}
+}
+BENCHMARK(stringify_raw);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,84 @@
+#include "benchmark/benchmark.h"
+#include "jsontype/Root.hpp"
+#include "jsontype/Root_batch.hpp"
+#include <string>
+#include <vector>
+
+using namespace jsontype;
+
+namespace
+{
+	JSONTYPE_MAKE_TAG(id);
+	JSONTYPE_MAKE_TAG(name);
+	JSONTYPE_MAKE_TAG(score);
+
+	using Payload_id = Value_field<id_tag, unsigned>;
+	using Payload_name = Value_field<name_tag, std::string>;
+	using Payload_score = Value_field<score_tag, double>;
+	using Record = Root<Payload_id, Payload_name, Payload_score>;
+	using Records = Root_batch<Payload_id, Payload_name, Payload_score>;
+
+	std::vector<std::string> make_records(std::size_t count)
+	{
+		std::vector<std::string> records;
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			records.push_back("{\"id\":" + std::to_string(i) + ",\"name\":\"record\",\"score\":0.5}");
+		}
+		return records;
+	}
+
+	std::string join(const std::vector<std::string>& records)
+	{
+		std::string json("[");
+		for (const auto& record : records)
+		{
+			json += (json.size() > 1 ? "," : "") + record;
+		}
+		return json + "]";
+	}
+}
+
+static void batch_parse(benchmark::State& state)
+{
+	const auto json = join(make_records(state.range(0)));
+	for (auto _ : state)
+	{
+		Records records(json);
+		benchmark::DoNotOptimize(records);
+	}
+}
+BENCHMARK(batch_parse)->Arg(16)->Arg(1024);
+
+static void batch_parse_roots(benchmark::State& state)
+{
+	const auto records = make_records(state.range(0));
+	for (auto _ : state)
+	{
+		std::vector<Record> roots;
+		roots.reserve(records.size());
+		for (const auto& record : records)
+		{
+			roots.emplace_back(record);
+		}
+		benchmark::DoNotOptimize(roots);
+	}
+}
+BENCHMARK(batch_parse_roots)->Arg(16)->Arg(1024);
+
+static void batch_push_back(benchmark::State& state)
+{
+	const auto records = make_records(state.range(0));
+	for (auto _ : state)
+	{
+		Records batch;
+		for (const auto& record : records)
+		{
+			batch.push_back(record);
+		}
+		benchmark::DoNotOptimize(batch);
+	}
+}
+BENCHMARK(batch_push_back)->Arg(16)->Arg(1024);
+
+BENCHMARK_MAIN();
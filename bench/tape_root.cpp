@@ -0,0 +1,66 @@
+#include "benchmark/benchmark.h"
+#include "jsontype/Root.hpp"
+#include "jsontype/Tape_root.hpp"
+#include <string>
+
+using namespace jsontype;
+
+namespace
+{
+	JSONTYPE_MAKE_TAG(id);
+	JSONTYPE_MAKE_TAG(name);
+	JSONTYPE_MAKE_TAG(contact);
+	JSONTYPE_MAKE_TAG(email);
+	JSONTYPE_MAKE_TAG(address);
+
+	using Contact = Object<contact_tag, Value_field<email_tag, std::string>, Value_field<address_tag, std::string>>;
+	using Person = Tape_root<Value_field<id_tag, unsigned>, Value_field<name_tag, std::string>, Contact>;
+
+	const std::string person_json("{\"id\":1,\"name\":\"Paul\",\"contact\":{\"email\":\"paul@example.com\","
+			"\"address\":\"74 Green St\"}}");
+}
+
+static void tape_parse(benchmark::State& state)
+{
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(Person(person_json));
+	}
+}
+BENCHMARK(tape_parse);
+
+static void tape_parse_raw(benchmark::State& state)
+{
+	for (auto _ : state)
+	{
+		rapidjson::Document doc;
+		doc.Parse(person_json);
+		benchmark::DoNotOptimize(doc);
+	}
+}
+BENCHMARK(tape_parse_raw);
+
+static void tape_find(benchmark::State& state)
+{
+	const Person person(person_json);
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(person[id_tag{}].get());
+		benchmark::DoNotOptimize(person[Key<contact_tag, address_tag>{}].ref().GetString());
+	}
+}
+BENCHMARK(tape_find);
+
+static void tape_find_raw(benchmark::State& state)
+{
+	rapidjson::Document doc;
+	doc.Parse(person_json);
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(doc["id"].GetUint());
+		benchmark::DoNotOptimize(doc["contact"]["address"].GetString());
+	}
+}
+BENCHMARK(tape_find_raw);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,292 @@
+// Copyright (C) 2017 Andrea Spurio. All rights reserved.
+//
+// Licensed under the MIT License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// http://opensource.org/licenses/MIT
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef JSONTYPE_DYNAMIC_PATH_HPP_
+#define JSONTYPE_DYNAMIC_PATH_HPP_
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <rapidjson/document.h>
+#include "Root.hpp"
+
+namespace jsontype
+{
+	namespace detail
+	{
+		template <typename Ch>
+		struct Path_segment
+		{
+			static constexpr auto npos = std::numeric_limits<std::size_t>::max();
+
+			std::basic_string<Ch> name;
+			// Position of the member's declaration in the schema, npos if the schema doesn't describe it
+			std::size_t position = npos;
+			// Index of the element when the segment is applied to an array, npos if the name isn't an index
+			std::size_t index = npos;
+		};
+
+		template <typename Ch>
+		constexpr std::size_t Path_segment<Ch>::npos;
+
+		template <typename Payload> struct Path_binder;
+
+		/**
+		 * Binds the segments starting from the given one to the members of an object with the given payloads
+		 *
+		 * @returns Whether all the segments are described by the payloads
+		 * @throws Bad_structure if a segment goes through a value field
+		 */
+		template <typename... Payloads, typename Segments>
+		bool bind_path(Segments& segments, std::size_t first)
+		{
+			if (first == segments.size())
+			{
+				return true;
+			}
+			auto& segment = segments[first];
+			bool described = false;
+			using Expander = int[];
+			(void)Expander{0, (segment.name.size() == Path_binder<Payloads>::name_tag::length()
+					&& segment.name.compare(Path_binder<Payloads>::name_tag::name()) == 0
+					&& (segment.position = Payload_index<Payloads, Payloads...>::value,
+							described = Path_binder<Payloads>::bind(segments, first + 1), true), 0)...};
+			return described;
+		}
+
+		template <typename Name_tag, typename... Payloads>
+		struct Path_binder<Object<Name_tag, Payloads...>>
+		{
+			using name_tag = Name_tag;
+
+			template <typename Segments>
+			static bool bind(Segments& segments, std::size_t next) { return bind_path<Payloads...>(segments, next); }
+		};
+
+		template <typename Name_tag, typename... Element>
+		struct Path_binder<Array<Name_tag, Element...>>
+		{
+			using name_tag = Name_tag;
+
+			// The elements of an array aren't described by the schema
+			template <typename Segments>
+			static bool bind(Segments& segments, std::size_t next) { return next == segments.size(); }
+		};
+
+		template <typename Name_tag, typename T>
+		struct Path_binder<Value_field<Name_tag, T>>
+		{
+			using name_tag = Name_tag;
+
+			template <typename Segments>
+			static bool bind(Segments& segments, std::size_t next)
+			{
+				if (next != segments.size())
+				{
+					throw Bad_structure(std::string("Path goes through the value field ") + Name_tag::name());
+				}
+				return true;
+			}
+		};
+
+		template <typename Root> struct Root_schema;
+
+		template <typename Document, typename... Payloads>
+		struct Root_schema<Generic_root<Document, Payloads...>>
+		{
+			using Ch = typename Document::Ch;
+
+			template <typename Segments>
+			static bool bind(Segments& segments) { return bind_path<Payloads...>(segments, 0); }
+		};
+	}
+
+	/**
+	 * Path to a node of a document, whose member names are known only at runtime.
+	 * The path is split once into segments, which are checked against the schema of the root and remember where
+	 * their member is declared; then it can be resolved against any number of documents.
+	 */
+	template <typename Root>
+	class Dynamic_path
+	{
+		using Schema = detail::Root_schema<Root>;
+	public:
+		using Ch = typename Schema::Ch;
+
+		/**
+		 * Compiles a path made of member names separated by dots, or a JSON Pointer if it starts with a slash.
+		 * Segments naming array elements are written as decimal indices
+		 *
+		 * @throws Invalid_argument if the JSON Pointer has a bad escape sequence, Bad_structure if the path goes
+		 * through a value field of the schema
+		 */
+		explicit Dynamic_path(const std::basic_string<Ch>& path);
+
+		/**
+		 * @returns Whether every segment of the path is described by the root's schema
+		 */
+		bool described() const { return described_; }
+		/**
+		 * @returns The number of segments of the path
+		 */
+		std::size_t size() const { return segments_.size(); }
+
+		/**
+		 * @returns The node at the end of the path, or a null pointer if the document doesn't have it
+		 */
+		auto find(const Root& root) const { return find(root.ref()); }
+
+		template <typename Json_ref>
+		const typename Json_ref::ValueType* find(const Json_ref&) const;
+	private:
+		using Segment = detail::Path_segment<Ch>;
+
+		void parse_dotted(const std::basic_string<Ch>&);
+		void parse_pointer(const std::basic_string<Ch>&);
+		void add_segment(std::basic_string<Ch>&&);
+
+		template <typename Json_ref>
+		static auto find_member(const Json_ref&, const Segment&);
+
+		std::vector<Segment> segments_;
+		bool described_;
+	};
+
+	//
+	// Definitions
+	//
+
+	template <typename Root>
+	Dynamic_path<Root>::Dynamic_path(const std::basic_string<Ch>& path)
+	{
+		if (!path.empty() && path[0] == Ch('/'))
+		{
+			parse_pointer(path);
+		}
+		else if (!path.empty())
+		{
+			parse_dotted(path);
+		}
+		described_ = Schema::bind(segments_);
+	}
+
+	template <typename Root>
+	void Dynamic_path<Root>::parse_dotted(const std::basic_string<Ch>& path)
+	{
+		std::size_t begin = 0;
+		for (;;)
+		{
+			const auto end = path.find(Ch('.'), begin);
+			add_segment(path.substr(begin, end - begin));
+			if (end == std::basic_string<Ch>::npos)
+			{
+				return;
+			}
+			begin = end + 1;
+		}
+	}
+
+	template <typename Root>
+	void Dynamic_path<Root>::parse_pointer(const std::basic_string<Ch>& path)
+	{
+		std::basic_string<Ch> name;
+		for (std::size_t i = 1; i <= path.size(); ++i)
+		{
+			if (i == path.size() || path[i] == Ch('/'))
+			{
+				add_segment(std::move(name));
+				name.clear();
+			}
+			else if (path[i] != Ch('~'))
+			{
+				name += path[i];
+			}
+			else if (i + 1 < path.size() && (path[i + 1] == Ch('0') || path[i + 1] == Ch('1')))
+			{
+				name += path[++i] == Ch('0') ? Ch('~') : Ch('/');
+			}
+			else
+			{
+				throw std::invalid_argument("Bad escape sequence at offset " + std::to_string(i) + " of a JSON Pointer");
+			}
+		}
+	}
+
+	template <typename Root>
+	void Dynamic_path<Root>::add_segment(std::basic_string<Ch>&& name)
+	{
+		Segment segment;
+		segment.name = std::move(name);
+		const auto& digits = segment.name;
+		const bool numeric = !digits.empty() && digits.size() < 10 && (digits[0] != Ch('0') || digits.size() == 1)
+				&& std::all_of(digits.cbegin(), digits.cend(), [](Ch c) { return c >= Ch('0') && c <= Ch('9'); });
+		if (numeric)
+		{
+			segment.index = 0;
+			for (const auto c : digits)
+			{
+				segment.index = segment.index * 10 + static_cast<std::size_t>(c - Ch('0'));
+			}
+		}
+		segments_.push_back(std::move(segment));
+	}
+
+	template <typename Root>
+	template <typename Json_ref>
+	const typename Json_ref::ValueType* Dynamic_path<Root>::find(const Json_ref& ref) const
+	{
+		const typename Json_ref::ValueType* node = &ref;
+		for (const auto& segment : segments_)
+		{
+			if (node->IsObject())
+			{
+				const auto member = find_member(*node, segment);
+				if (member == node->MemberEnd())
+				{
+					return nullptr;
+				}
+				node = &member->value;
+			}
+			else if (node->IsArray() && segment.index < node->Size())
+			{
+				node = &(*node)[static_cast<rapidjson::SizeType>(segment.index)];
+			}
+			else
+			{
+				return nullptr;
+			}
+		}
+		return node;
+	}
+
+	template <typename Root>
+	template <typename Json_ref>
+	auto Dynamic_path<Root>::find_member(const Json_ref& ref, const Segment& segment)
+	{
+		if (segment.position < ref.MemberCount())
+		{
+			const auto member = ref.MemberBegin() + segment.position;
+			if (member->name.GetStringLength() == segment.name.size() && std::char_traits<Ch>::compare(
+					member->name.GetString(), segment.name.data(), segment.name.size()) == 0)
+			{
+				return member;
+			}
+		}
+		const Json_ref name(rapidjson::StringRef(segment.name.data(), segment.name.size()));
+		return ref.FindMember(name);
+	}
+}
+
+#endif
@@ -0,0 +1,571 @@
+// Copyright (C) 2017 Andrea Spurio. All rights reserved.
+//
+// Licensed under the MIT License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// http://opensource.org/licenses/MIT
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef JSONTYPE_INCREMENTAL_PARSER_HPP_
+#define JSONTYPE_INCREMENTAL_PARSER_HPP_
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include <type_traits>
+#include <rapidjson/document.h>
+#include <rapidjson/reader.h>
+#include <rapidjson/stream.h>
+#include "Root.hpp"
+
+namespace jsontype
+{
+	namespace detail
+	{
+		/**
+		 * Reader handler keeping the number it's given, so that numbers are converted by rapidjson regardless of
+		 * the locale
+		 */
+		struct Number_handler : rapidjson::BaseReaderHandler<rapidjson::UTF8<>, Number_handler>
+		{
+			rapidjson::Value value;
+
+			bool Default() { return false; }
+			bool Int(int i) { value.SetInt(i); return true; }
+			bool Uint(unsigned u) { value.SetUint(u); return true; }
+			bool Int64(std::int64_t i) { value.SetInt64(i); return true; }
+			bool Uint64(std::uint64_t u) { value.SetUint64(u); return true; }
+			bool Double(double d) { value.SetDouble(d); return true; }
+		};
+	}
+
+	/**
+	 * Push parser building a root out of a json received in chunks of any size.
+	 * The parsing state is kept between the chunks, so that only the token being read is buffered; the structure
+	 * of the document is checked once it's complete.
+	 */
+	template <typename Root>
+	class Incremental_parser
+	{
+		using Document = std::decay_t<decltype(std::declval<const Root&>().document())>;
+		static_assert(std::is_same<typename Document::Ch, char>::value, "The incremental parser reads UTF-8 documents");
+	public:
+		Incremental_parser() = default;
+		Incremental_parser(const Incremental_parser&) = delete;
+		Incremental_parser& operator=(const Incremental_parser&) = delete;
+
+		/**
+		 * Parses the next chunk of the json. Parsing stops at the end of the document, the remaining characters
+		 * belong to whatever comes after it
+		 *
+		 * @returns The number of characters consumed
+		 * @throws Bad_structure if the json is malformed
+		 */
+		std::size_t feed(const char* data, std::size_t length);
+		std::size_t feed(const std::string& data) { return feed(data.data(), data.size()); }
+
+		/**
+		 * @returns Whether a whole document was parsed
+		 */
+		bool done() const { return state_ == State::done; }
+
+		/**
+		 * Hands over the parsed document and gets ready to parse a new one
+		 *
+		 * @throws Bad_structure if the document isn't complete or its structure is not compatible with the root
+		 */
+		Root take();
+	private:
+		enum class State
+		{
+			start,
+			value,
+			first_value,
+			first_key,
+			key,
+			colon,
+			next,
+			string,
+			escape,
+			unicode,
+			surrogate_escape,
+			surrogate_unicode,
+			number,
+			literal,
+			done,
+			failed
+		};
+
+		struct Frame
+		{
+			explicit Frame(rapidjson::Type type) : value(type) {}
+			rapidjson::Value value;
+			rapidjson::Value key;
+		};
+
+		bool consume(char);
+		void open(rapidjson::Type);
+		void close();
+		void add(rapidjson::Value&);
+		void end_string();
+		bool end_unicode();
+		void end_number();
+		void end_literal();
+		[[noreturn]] void fail();
+
+		static bool whitespace(char c) { return c == ' ' || c == '\n' || c == '\r' || c == '\t'; }
+		static bool valid_number(const std::string&);
+
+		rapidjson::Document document_;
+		std::vector<Frame> stack_;
+		State state_ = State::start;
+		std::string token_;
+		bool key_ = false;
+		unsigned code_point_ = 0;
+		unsigned high_surrogate_ = 0;
+		int hex_digits_ = 0;
+		std::size_t offset_ = 0;
+	};
+
+	//
+	// Definitions
+	//
+
+	template <typename Root>
+	std::size_t Incremental_parser<Root>::feed(const char* data, std::size_t length)
+	{
+		if (state_ == State::failed)
+		{
+			fail();
+		}
+		std::size_t i = 0;
+		for (; i < length && state_ != State::done; ++i, ++offset_)
+		{
+			while (!consume(data[i])) {}
+		}
+		return i;
+	}
+
+	template <typename Root>
+	Root Incremental_parser<Root>::take()
+	{
+		if (!done())
+		{
+			throw Bad_structure(std::string("Incomplete json"));
+		}
+		auto document = std::move(document_);
+		document_ = rapidjson::Document();
+		state_ = State::start;
+		offset_ = 0;
+		return Root(std::move(document));
+	}
+
+	/**
+	 * Reads one character in the current state.
+	 * Numbers and literals have no closing character, the one following them is left to the next state.
+	 *
+	 * @returns Whether the character was consumed
+	 */
+	template <typename Root>
+	bool Incremental_parser<Root>::consume(char c)
+	{
+		switch (state_)
+		{
+		case State::start:
+			if (c == '{')
+			{
+				open(rapidjson::kObjectType);
+			}
+			else if (!whitespace(c))
+			{
+				fail();
+			}
+			return true;
+		case State::first_value:
+			if (c == ']')
+			{
+				close();
+				return true;
+			}
+			if (whitespace(c))
+			{
+				return true;
+			}
+			state_ = State::value;
+			return false;
+		case State::value:
+			if (c == '{')
+			{
+				open(rapidjson::kObjectType);
+			}
+			else if (c == '[')
+			{
+				open(rapidjson::kArrayType);
+			}
+			else if (c == '"')
+			{
+				key_ = false;
+				token_.clear();
+				state_ = State::string;
+			}
+			else if (c == '-' || (c >= '0' && c <= '9'))
+			{
+				token_.assign(1, c);
+				state_ = State::number;
+			}
+			else if (c == 't' || c == 'f' || c == 'n')
+			{
+				token_.assign(1, c);
+				state_ = State::literal;
+			}
+			else if (!whitespace(c))
+			{
+				fail();
+			}
+			return true;
+		case State::first_key:
+			if (c == '}')
+			{
+				close();
+				return true;
+			}
+			// fall through
+		case State::key:
+			if (c == '"')
+			{
+				key_ = true;
+				token_.clear();
+				state_ = State::string;
+			}
+			else if (!whitespace(c))
+			{
+				fail();
+			}
+			return true;
+		case State::colon:
+			if (c == ':')
+			{
+				state_ = State::value;
+			}
+			else if (!whitespace(c))
+			{
+				fail();
+			}
+			return true;
+		case State::next:
+			if (c == ',')
+			{
+				state_ = stack_.back().value.IsObject() ? State::key : State::value;
+			}
+			else if ((c == '}' && stack_.back().value.IsObject()) || (c == ']' && stack_.back().value.IsArray()))
+			{
+				close();
+			}
+			else if (!whitespace(c))
+			{
+				fail();
+			}
+			return true;
+		case State::string:
+			if (c == '"')
+			{
+				end_string();
+			}
+			else if (c == '\\')
+			{
+				state_ = State::escape;
+			}
+			else if (static_cast<unsigned char>(c) < 0x20)
+			{
+				fail();
+			}
+			else
+			{
+				token_ += c;
+			}
+			return true;
+		case State::escape:
+		{
+			static const char escapes[] = "\"\"\\\\//b\bf\fn\nr\rt\t";
+			if (c == 'u')
+			{
+				code_point_ = 0;
+				hex_digits_ = 0;
+				state_ = State::unicode;
+				return true;
+			}
+			for (std::size_t i = 0; i < sizeof(escapes) - 1; i += 2)
+			{
+				if (escapes[i] == c)
+				{
+					token_ += escapes[i + 1];
+					state_ = State::string;
+					return true;
+				}
+			}
+			fail();
+		}
+		case State::surrogate_escape:
+			if (c != '\\')
+			{
+				fail();
+			}
+			state_ = State::surrogate_unicode;
+			return true;
+		case State::surrogate_unicode:
+			if (c != 'u')
+			{
+				fail();
+			}
+			code_point_ = 0;
+			hex_digits_ = 0;
+			state_ = State::unicode;
+			return true;
+		case State::unicode:
+			code_point_ <<= 4;
+			if (c >= '0' && c <= '9')
+			{
+				code_point_ |= c - '0';
+			}
+			else if (c >= 'a' && c <= 'f')
+			{
+				code_point_ |= c - 'a' + 10;
+			}
+			else if (c >= 'A' && c <= 'F')
+			{
+				code_point_ |= c - 'A' + 10;
+			}
+			else
+			{
+				fail();
+			}
+			if (++hex_digits_ == 4 && !end_unicode())
+			{
+				fail();
+			}
+			return true;
+		case State::number:
+			if ((c >= '0' && c <= '9') || c == '.' || c == 'e' || c == 'E' || c == '+' || c == '-')
+			{
+				token_ += c;
+				return true;
+			}
+			end_number();
+			return false;
+		case State::literal:
+			if (c >= 'a' && c <= 'z' && token_.size() < 5)
+			{
+				token_ += c;
+				return true;
+			}
+			end_literal();
+			return false;
+		case State::done:
+			return true;
+		case State::failed:
+			fail();
+		}
+		return true;
+	}
+
+	template <typename Root>
+	void Incremental_parser<Root>::open(rapidjson::Type type)
+	{
+		stack_.emplace_back(type);
+		state_ = type == rapidjson::kObjectType ? State::first_key : State::first_value;
+	}
+
+	template <typename Root>
+	void Incremental_parser<Root>::close()
+	{
+		rapidjson::Value value(std::move(stack_.back().value));
+		stack_.pop_back();
+		if (stack_.empty())
+		{
+			static_cast<rapidjson::Value&>(document_) = value;
+			state_ = State::done;
+			return;
+		}
+		add(value);
+	}
+
+	template <typename Root>
+	void Incremental_parser<Root>::add(rapidjson::Value& value)
+	{
+		auto& top = stack_.back();
+		if (top.value.IsObject())
+		{
+			top.value.AddMember(top.key, value, document_.GetAllocator());
+		}
+		else
+		{
+			top.value.PushBack(value, document_.GetAllocator());
+		}
+		state_ = State::next;
+	}
+
+	template <typename Root>
+	void Incremental_parser<Root>::end_string()
+	{
+		rapidjson::Value value(token_.data(), static_cast<rapidjson::SizeType>(token_.size()), document_.GetAllocator());
+		if (key_)
+		{
+			stack_.back().key = value;
+			state_ = State::colon;
+			return;
+		}
+		add(value);
+	}
+
+	/**
+	 * Appends the UTF-8 encoding of the escaped code point, combining surrogate pairs
+	 *
+	 * @returns False if the code point is an unpaired surrogate
+	 */
+	template <typename Root>
+	bool Incremental_parser<Root>::end_unicode()
+	{
+		auto code_point = code_point_;
+		if (high_surrogate_)
+		{
+			if (code_point < 0xDC00 || code_point > 0xDFFF)
+			{
+				return false;
+			}
+			code_point = 0x10000 + ((high_surrogate_ - 0xD800) << 10) + (code_point - 0xDC00);
+			high_surrogate_ = 0;
+		}
+		else if (code_point >= 0xD800 && code_point <= 0xDBFF)
+		{
+			high_surrogate_ = code_point;
+			state_ = State::surrogate_escape;
+			return true;
+		}
+		else if (code_point >= 0xDC00 && code_point <= 0xDFFF)
+		{
+			return false;
+		}
+		if (code_point < 0x80)
+		{
+			token_ += static_cast<char>(code_point);
+		}
+		else if (code_point < 0x800)
+		{
+			token_ += static_cast<char>(0xC0 | (code_point >> 6));
+			token_ += static_cast<char>(0x80 | (code_point & 0x3F));
+		}
+		else if (code_point < 0x10000)
+		{
+			token_ += static_cast<char>(0xE0 | (code_point >> 12));
+			token_ += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+			token_ += static_cast<char>(0x80 | (code_point & 0x3F));
+		}
+		else
+		{
+			token_ += static_cast<char>(0xF0 | (code_point >> 18));
+			token_ += static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+			token_ += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+			token_ += static_cast<char>(0x80 | (code_point & 0x3F));
+		}
+		state_ = State::string;
+		return true;
+	}
+
+	template <typename Root>
+	void Incremental_parser<Root>::end_number()
+	{
+		if (!valid_number(token_))
+		{
+			fail();
+		}
+		detail::Number_handler handler;
+		rapidjson::StringStream stream(token_.c_str());
+		rapidjson::Reader reader;
+		if (reader.Parse(stream, handler).IsError())
+		{
+			fail();
+		}
+		add(handler.value);
+	}
+
+	template <typename Root>
+	void Incremental_parser<Root>::end_literal()
+	{
+		rapidjson::Value value;
+		if (token_ == "true")
+		{
+			value.SetBool(true);
+		}
+		else if (token_ == "false")
+		{
+			value.SetBool(false);
+		}
+		else if (token_ != "null")
+		{
+			fail();
+		}
+		add(value);
+	}
+
+	template <typename Root>
+	void Incremental_parser<Root>::fail()
+	{
+		state_ = State::failed;
+		throw Bad_structure("Invalid json at offset " + std::to_string(offset_));
+	}
+
+	/**
+	 * Checks the json number grammar: -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?
+	 */
+	template <typename Root>
+	bool Incremental_parser<Root>::valid_number(const std::string& token)
+	{
+		const auto digit = [&token](std::size_t i) { return i < token.size() && token[i] >= '0' && token[i] <= '9'; };
+		std::size_t i = token[0] == '-' ? 1 : 0;
+		if (!digit(i))
+		{
+			return false;
+		}
+		if (token[i++] != '0')
+		{
+			while (digit(i))
+			{
+				++i;
+			}
+		}
+		if (i < token.size() && token[i] == '.')
+		{
+			if (!digit(++i))
+			{
+				return false;
+			}
+			while (digit(i))
+			{
+				++i;
+			}
+		}
+		if (i < token.size() && (token[i] == 'e' || token[i] == 'E'))
+		{
+			if (++i < token.size() && (token[i] == '+' || token[i] == '-'))
+			{
+				++i;
+			}
+			if (!digit(i))
+			{
+				return false;
+			}
+			while (digit(i))
+			{
+				++i;
+			}
+		}
+		return i == token.size();
+	}
+}
+
+#endif
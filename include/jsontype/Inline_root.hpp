@@ -0,0 +1,247 @@
+// Copyright (C) 2017 Andrea Spurio. All rights reserved.
+//
+// Licensed under the MIT License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// http://opensource.org/licenses/MIT
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef JSONTYPE_INLINE_ROOT_HPP_
+#define JSONTYPE_INLINE_ROOT_HPP_
+
+#include <string>
+#include <tuple>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <rapidjson/document.h>
+#include <rapidjson/writer.h>
+#include <rapidjson/stringbuffer.h>
+#include "Root.hpp"
+
+namespace jsontype
+{
+	namespace detail
+	{
+		template <typename T> struct Inline_value : std::false_type {};
+		template <> struct Inline_value<bool> : std::true_type {};
+		template <> struct Inline_value<int> : std::true_type {};
+		template <> struct Inline_value<unsigned> : std::true_type {};
+		template <> struct Inline_value<std::int64_t> : std::true_type {};
+		template <> struct Inline_value<std::uint64_t> : std::true_type {};
+		template <> struct Inline_value<float> : std::true_type {};
+		template <> struct Inline_value<double> : std::true_type {};
+		template <> struct Inline_value<std::string> : std::true_type {};
+
+		template <typename Payload>
+		struct Inline_field
+		{
+			static_assert(Signal_error<Payload>::value, "Inline roots can only hold value fields");
+		};
+
+		template <typename Name_tag, typename T>
+		struct Inline_field<Value_field<Name_tag, T>>
+		{
+			static_assert(Inline_value<T>::value, "Inline roots can only hold numbers, booleans and std::string");
+
+			using name_tag = Name_tag;
+			using type = T;
+		};
+
+		template <typename Writer> void write_value(Writer& writer, bool value) { writer.Bool(value); }
+		template <typename Writer> void write_value(Writer& writer, int value) { writer.Int(value); }
+		template <typename Writer> void write_value(Writer& writer, unsigned value) { writer.Uint(value); }
+		template <typename Writer> void write_value(Writer& writer, std::int64_t value) { writer.Int64(value); }
+		template <typename Writer> void write_value(Writer& writer, std::uint64_t value) { writer.Uint64(value); }
+		template <typename Writer> void write_value(Writer& writer, float value) { writer.Double(value); }
+		template <typename Writer> void write_value(Writer& writer, double value) { writer.Double(value); }
+
+		template <typename Writer>
+		void write_value(Writer& writer, const std::string& value)
+		{
+			writer.String(value.data(), static_cast<rapidjson::SizeType>(value.size()));
+		}
+	}
+
+	/**
+	 * Handle to a field of an inline root, dropping the root's document when the field is changed
+	 */
+	template <typename T, typename Document_cache>
+	class Inline_field_proxy
+	{
+		typedef typename detail::Value_traits<T>::Param_type Param_type;
+	public:
+		typedef T Value_type;
+
+		Inline_field_proxy(T& value, Document_cache& cache) : value_(value), cache_(cache) {}
+
+		void set(Param_type val) { value_ = val; cache_.reset(); }
+		const T& get() const { return value_; }
+		operator T() const { return value_; }
+		Inline_field_proxy& operator=(Param_type val) { set(val); return *this; }
+	private:
+		T& value_;
+		Document_cache& cache_;
+	};
+
+	/**
+	 * Read-only handle to a field of an inline root
+	 */
+	template <typename T>
+	class Inline_const_field_proxy
+	{
+	public:
+		typedef T Value_type;
+
+		explicit Inline_const_field_proxy(const T& value) : value_(value) {}
+
+		const T& get() const { return value_; }
+		operator T() const { return value_; }
+	private:
+		const T& value_;
+	};
+
+	/**
+	 * Root of a json entity made of a few value fields, which are stored in place rather than in a json document.
+	 * Fields are read and written directly; the document is built only when it's asked for and kept until a field
+	 * changes. Members not described by the payloads are dropped when parsing, so the document and the
+	 * serialization always hold the same fields.
+	 * The document is built by the const document() and ref(), which must therefore not be called concurrently
+	 * on the same root.
+	 */
+	template <typename... Payloads>
+	class Inline_root
+	{
+		using Values = std::tuple<typename detail::Inline_field<Payloads>::type...>;
+		using Materialized = Root<Payloads...>;
+		using Document_cache = std::unique_ptr<Materialized>;
+	public:
+		/**
+		 * Creates an object with all fields defaulted
+		 */
+		Inline_root() : values_(detail::Value_traits<typename detail::Inline_field<Payloads>::type>::default_value()...)
+		{}
+		/**
+		 * Creates an object populated with the values parsed from the given json string
+		 *
+		 * @throws Bad_structure if the json string's structure is not compatible with this type
+		 */
+		explicit Inline_root(const std::string& json) : Inline_root(Materialized(json)) {}
+		/**
+		 * Creates an object populated with the values of the given document
+		 *
+		 * @throws Bad_structure if the document's structure is not compatible with this type
+		 */
+		explicit Inline_root(rapidjson::Document&& doc) : Inline_root(Materialized(std::move(doc))) {}
+		Inline_root(Inline_root&&) = default;
+		Inline_root& operator=(Inline_root&&) = default;
+
+		template <typename Name_tag>
+		auto find(Name_tag)
+		{
+			return Inline_field_proxy<Field<Name_tag>, Document_cache>(std::get<index<Name_tag>()>(values_), document_);
+		}
+
+		template <typename Name_tag>
+		auto find(Name_tag) const
+		{
+			return Inline_const_field_proxy<Field<Name_tag>>(std::get<index<Name_tag>()>(values_));
+		}
+
+		template <typename Name_tag>
+		auto operator[](Name_tag tag) { return find(tag); }
+
+		template <typename Name_tag>
+		auto operator[](Name_tag tag) const { return find(tag); }
+
+		/**
+		 * @returns A reference to a json document holding the values of this object, built if needed. Building it
+		 * changes the root, so it's not safe to call concurrently with any other access
+		 */
+		const auto& document() const { return materialize().document(); }
+		/**
+		 * @returns A reference to the underlying rapidjson object, built if needed
+		 */
+		const auto& ref() const { return document(); }
+		/**
+		 * @returns A json string representation of this object, written straight from its values
+		 */
+		auto stringify() const;
+		/**
+		 * Writes the json representation of this object into the given rapidjson output stream
+		 */
+		template <typename Output_stream>
+		void stringify_to(Output_stream& os) const;
+	private:
+		template <typename Name_tag>
+		using Payload = typename detail::Payload_finder<Name_tag, Payloads...>::type;
+
+		template <typename Name_tag>
+		using Field = typename detail::Inline_field<Payload<Name_tag>>::type;
+
+		template <typename Name_tag>
+		static constexpr std::size_t index() { return detail::Payload_index<Payload<Name_tag>, Payloads...>::value; }
+
+		explicit Inline_root(const Materialized& root);
+
+		const Materialized& materialize() const;
+
+		Values values_;
+		mutable Document_cache document_;
+	};
+
+	//
+	// Definitions
+	//
+
+	// The parsed document is not kept, since it may hold more members than the fields
+	template <typename... Payloads>
+	Inline_root<Payloads...>::Inline_root(const Materialized& root)
+			: values_(root[typename detail::Inline_field<Payloads>::name_tag{}].get()...)
+	{}
+
+	template <typename... Payloads>
+	auto Inline_root<Payloads...>::stringify() const
+	{
+		rapidjson::StringBuffer buffer;
+		stringify_to(buffer);
+		return std::string(buffer.GetString(), buffer.GetSize());
+	}
+
+	template <typename... Payloads>
+	template <typename Output_stream>
+	void Inline_root<Payloads...>::stringify_to(Output_stream& os) const
+	{
+		rapidjson::Writer<Output_stream> writer(os);
+		writer.StartObject();
+		using Expander = int[];
+		(void)Expander{0, (writer.Key(detail::Inline_field<Payloads>::name_tag::name(),
+				static_cast<rapidjson::SizeType>(detail::Inline_field<Payloads>::name_tag::length())),
+				detail::write_value(writer, std::get<detail::Payload_index<Payloads, Payloads...>::value>(values_)),
+				0)...};
+		writer.EndObject(sizeof...(Payloads));
+		os.Flush();
+	}
+
+	template <typename... Payloads>
+	auto Inline_root<Payloads...>::materialize() const -> const Materialized&
+	{
+		if (!document_)
+		{
+			auto root = std::make_unique<Materialized>();
+			using Expander = int[];
+			(void)Expander{0, ((*root)[typename detail::Inline_field<Payloads>::name_tag{}] =
+					std::get<detail::Payload_index<Payloads, Payloads...>::value>(values_), 0)...};
+			document_ = std::move(root);
+		}
+		return *document_;
+	}
+}
+
+#endif
@@ -13,12 +13,14 @@
 #ifndef JSONTYPE_KEY_HPP_
 #define JSONTYPE_KEY_HPP_
 
+#include <cstdint>
 #include "detail/Utility.hpp"
 
 #define JSONTYPE_STRING(S) #S
 
 /**
- * Declares and defines a new type 'X_tag' with a name() member that returns X
+ * Declares and defines a new type 'X_tag' with a name() member that returns X.
+ * Tags get the length and the hash of their name at compile time from the Tag base class.
  */
 #define JSONTYPE_MAKE_TAG(X)               									  \
 	struct X ## _tag : Tag<X ## _tag> { static constexpr auto name() { return JSONTYPE_STRING(X); } }  \
@@ -30,6 +32,14 @@ namespace jsontype
 	{
 		using type = T;
 		static constexpr auto name();
+		/**
+		 * @returns The length of the tag's name
+		 */
+		static constexpr std::size_t length() { return detail::string_length(T::name()); }
+		/**
+		 * @returns The hash of the tag's name
+		 */
+		static constexpr std::size_t hash() { return detail::string_hash(T::name(), T::length()); }
 	};
 
 	namespace detail
@@ -89,6 +99,46 @@ namespace jsontype
 		using Args = detail::Pack<K_1..., K_2...>;
 	};
 
+	/**
+	 * Key element matching the member named by Name_tag when its value is the string given by Value_tag's name.
+	 * The key elements following it are matched against the same object
+	 */
+	template <typename Name_tag, typename Value_tag>
+	struct Value_match : Tag<Value_match<Name_tag, Value_tag>>
+	{
+		static_assert(detail::is_all_tags<Name_tag, Value_tag>(), "Value matches must contain only tag classes");
+		using value_tag = Value_tag;
+		static constexpr auto name() { return Name_tag::name(); }
+	};
+
+	/**
+	 * Key element matching the member named by Name_tag when its value is the given integer.
+	 * The key elements following it are matched against the same object
+	 */
+	template <typename Name_tag, std::int64_t Value>
+	struct Int_match : Tag<Int_match<Name_tag, Value>>
+	{
+		static_assert(detail::is_tag<Name_tag>(), "Name tag template argument must be a tag class");
+		static constexpr std::int64_t value() { return Value; }
+		static constexpr auto name() { return Name_tag::name(); }
+	};
+
+	namespace detail
+	{
+		struct Name_element {};
+		struct String_element {};
+		struct Int_element {};
+
+		template <typename T>
+		struct Key_element { using type = Name_element; };
+
+		template <typename Name_tag, typename Value_tag>
+		struct Key_element<Value_match<Name_tag, Value_tag>> { using type = String_element; };
+
+		template <typename Name_tag, std::int64_t Value>
+		struct Key_element<Int_match<Name_tag, Value>> { using type = Int_element; };
+	}
+
 	template <typename T, typename... K>
 	auto operator+(T, Key<K...>) { return Key<typename T::type, Key<K...>>{}; }
 
@@ -0,0 +1,115 @@
+// Copyright (C) 2017 Andrea Spurio. All rights reserved.
+//
+// Licensed under the MIT License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// http://opensource.org/licenses/MIT
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef JSONTYPE_OUTPUT_STREAM_HPP_
+#define JSONTYPE_OUTPUT_STREAM_HPP_
+
+#include <cstddef>
+#include <cerrno>
+#include <system_error>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#define JSONTYPE_HAS_FD_STREAM 1
+#endif
+
+namespace jsontype
+{
+	/**
+	 * Rapidjson output stream writing into a fixed size buffer.
+	 * Characters exceeding the buffer's size are counted but discarded.
+	 */
+	template <typename Ch_type = char>
+	class Span_output_stream
+	{
+	public:
+		typedef Ch_type Ch;
+
+		Span_output_stream(Ch* data, std::size_t size) : data_(data), size_(size) {}
+
+		void Put(Ch c)
+		{
+			if (length_ < size_)
+			{
+				data_[length_] = c;
+			}
+			++length_;
+		}
+		void Flush() {}
+
+		/**
+		 * @returns The number of characters put in the stream, including the discarded ones
+		 */
+		std::size_t length() const { return length_; }
+		bool truncated() const { return length_ > size_; }
+	private:
+		Ch* data_;
+		std::size_t size_;
+		std::size_t length_ = 0;
+	};
+
+#ifdef JSONTYPE_HAS_FD_STREAM
+	/**
+	 * Buffered rapidjson output stream writing into a file descriptor.
+	 * The buffer is written out only on Flush(), which the stringify_to() functions call when they are done.
+	 */
+	class Fd_output_stream
+	{
+	public:
+		typedef char Ch;
+
+		explicit Fd_output_stream(int fd) : fd_(fd) {}
+		Fd_output_stream(const Fd_output_stream&) = delete;
+		Fd_output_stream& operator=(const Fd_output_stream&) = delete;
+
+		void Put(Ch c)
+		{
+			if (size_ == sizeof(buffer_))
+			{
+				Flush();
+			}
+			buffer_[size_++] = c;
+		}
+
+		/**
+		 * @throws std::system_error if the write fails
+		 */
+		void Flush();
+	private:
+		int fd_;
+		std::size_t size_ = 0;
+		Ch buffer_[4096];
+	};
+
+	inline void Fd_output_stream::Flush()
+	{
+		std::size_t offset = 0;
+		while (offset < size_)
+		{
+			const auto written = ::write(fd_, buffer_ + offset, size_ - offset);
+			if (written < 0)
+			{
+				if (errno == EINTR)
+				{
+					continue;
+				}
+				size_ = 0;
+				throw std::system_error(errno, std::generic_category(), "Cannot write json");
+			}
+			offset += static_cast<std::size_t>(written);
+		}
+		size_ = 0;
+	}
+#endif
+}
+
+#endif
@@ -0,0 +1,382 @@
+// Copyright (C) 2017 Andrea Spurio. All rights reserved.
+//
+// Licensed under the MIT License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// http://opensource.org/licenses/MIT
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef JSONTYPE_PROJECTION_HPP_
+#define JSONTYPE_PROJECTION_HPP_
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <rapidjson/document.h>
+#include <rapidjson/reader.h>
+#include <rapidjson/memorystream.h>
+#include "Root.hpp"
+
+namespace jsontype
+{
+	namespace detail
+	{
+		/**
+		 * @returns The first of the given characters found in a range, or its end. The range is read a word at a
+		 * time and only the word holding a match is looked at byte by byte
+		 */
+		template <char... Cs>
+		const char* find_first_of(const char* begin, const char* end);
+
+		template <typename Payload> struct Projected_member;
+
+		/**
+		 * Builder of a document out of the members of a json text described by a schema.
+		 * Declared members are parsed by rapidjson; the others are skipped by matching quotes and brackets, without
+		 * allocating or converting anything, so they are not validated either
+		 */
+		class Projector
+		{
+		public:
+			using Allocator = rapidjson::Document::AllocatorType;
+
+			Projector(const char* json, std::size_t length, Allocator& alloc)
+					: pos_(json), end_(json + length), alloc_(alloc), parser_(&alloc)
+			{}
+
+			/**
+			 * Builds the whole document, which must be an object
+			 *
+			 * @throws Bad_structure if the json is not valid
+			 */
+			template <typename... Payloads>
+			void document(rapidjson::Value& out);
+
+			/**
+			 * Builds the object at the current position, keeping only the members with the given payloads
+			 */
+			template <typename... Payloads>
+			void object(rapidjson::Value& out);
+
+			/**
+			 * Parses the value at the current position
+			 */
+			void value(rapidjson::Value& out);
+
+			bool at_object() { skip_whitespace(); return pos_ != end_ && *pos_ == '{'; }
+		private:
+			template <typename Payload>
+			void add_member(rapidjson::Value&& name, rapidjson::Value& out);
+
+			void skip_whitespace();
+			void expect(char c);
+			void skip_value();
+			void skip_string();
+			void skip_container();
+
+			[[noreturn]] void fail() const { throw Bad_structure(std::string("Not a valid json")); }
+
+			const char* pos_;
+			const char* end_;
+			Allocator& alloc_;
+			// Parses the declared values, reusing its stack across them
+			rapidjson::Document parser_;
+		};
+
+		template <typename Name_tag, typename... Payloads>
+		struct Projected_member<Object<Name_tag, Payloads...>>
+		{
+			using name_tag = Name_tag;
+
+			static void project(Projector& projector, rapidjson::Value& out)
+			{
+				// Anything else is parsed as it is and rejected by the structure check
+				if (projector.at_object())
+				{
+					projector.object<Payloads...>(out);
+				}
+				else
+				{
+					projector.value(out);
+				}
+			}
+		};
+
+		template <typename Name_tag, typename... Element>
+		struct Projected_member<Array<Name_tag, Element...>>
+		{
+			using name_tag = Name_tag;
+
+			static void project(Projector& projector, rapidjson::Value& out) { projector.value(out); }
+		};
+
+		template <typename Name_tag, typename T>
+		struct Projected_member<Value_field<Name_tag, T>>
+		{
+			using name_tag = Name_tag;
+
+			static void project(Projector& projector, rapidjson::Value& out) { projector.value(out); }
+		};
+
+		template <typename Root> struct Projected_root;
+
+		template <typename Document, typename... Payloads>
+		struct Projected_root<Generic_root<Document, Payloads...>>
+		{
+			static void project(Projector& projector, rapidjson::Value& out)
+			{
+				projector.document<Payloads...>(out);
+			}
+		};
+	}
+
+	/**
+	 * Creates a root out of a json string, building only the members described by its structure. Undeclared
+	 * members are skipped without being parsed, so the cost depends on the declared members rather than on the
+	 * size of the json
+	 *
+	 * @throws Bad_structure if the json is not valid or its structure is not compatible with the root
+	 */
+	template <typename Root>
+	Root project(const char* json, std::size_t length);
+
+	template <typename Root>
+	Root project(const std::string& json) { return project<Root>(json.data(), json.size()); }
+
+	//
+	// Definitions
+	//
+
+	template <typename Root>
+	Root project(const char* json, std::size_t length)
+	{
+		rapidjson::Document doc;
+		detail::Projector projector(json, length, doc.GetAllocator());
+		detail::Projected_root<Root>::project(projector, doc);
+		return Root(std::move(doc));
+	}
+
+	namespace detail
+	{
+		template <char... Cs>
+		const char* find_first_of(const char* begin, const char* end)
+		{
+			using Word = std::uint64_t;
+			constexpr Word ones = 0x0101010101010101ull;
+			constexpr Word highs = 0x8080808080808080ull;
+			for (; end - begin >= static_cast<std::ptrdiff_t>(sizeof(Word)); begin += sizeof(Word))
+			{
+				Word word;
+				std::memcpy(&word, begin, sizeof(Word));
+				// A byte equal to c turns into zero, which the subtraction flags in the high bit
+				Word found = 0;
+				using Expander = int[];
+				(void)Expander{0, (found |= ((word ^ ones * static_cast<unsigned char>(Cs)) - ones)
+						& ~(word ^ ones * static_cast<unsigned char>(Cs)) & highs, 0)...};
+				if (found)
+				{
+					break;
+				}
+			}
+			for (; begin != end; ++begin)
+			{
+				bool match = false;
+				using Expander = int[];
+				(void)Expander{0, (match |= *begin == Cs, 0)...};
+				if (match)
+				{
+					return begin;
+				}
+			}
+			return end;
+		}
+
+		template <typename... Payloads>
+		void Projector::document(rapidjson::Value& out)
+		{
+			if (!at_object())
+			{
+				fail();
+			}
+			object<Payloads...>(out);
+			skip_whitespace();
+			if (pos_ != end_)
+			{
+				fail();
+			}
+		}
+
+		template <typename... Payloads>
+		void Projector::object(rapidjson::Value& out)
+		{
+			expect('{');
+			out.SetObject();
+			skip_whitespace();
+			if (pos_ != end_ && *pos_ == '}')
+			{
+				++pos_;
+				return;
+			}
+			for (;;)
+			{
+				skip_whitespace();
+				const char* name = pos_ + 1;
+				skip_string();
+				auto length = static_cast<rapidjson::SizeType>(pos_ - 1 - name);
+				rapidjson::Value unescaped;
+				if (std::memchr(name, '\\', length))
+				{
+					// Escaped names are rare enough to be handed to rapidjson
+					pos_ = name - 1;
+					value(unescaped);
+					name = unescaped.GetString();
+					length = unescaped.GetStringLength();
+				}
+				expect(':');
+				skip_whitespace();
+
+				bool declared = false;
+				using Expander = int[];
+				(void)Expander{0, (!declared
+						&& length == Projected_member<Payloads>::name_tag::length()
+						&& std::memcmp(name, Projected_member<Payloads>::name_tag::name(), length) == 0
+						&& (add_member<Payloads>(rapidjson::Value(name, length, alloc_), out), declared = true), 0)...};
+				if (!declared)
+				{
+					skip_value();
+				}
+
+				skip_whitespace();
+				if (pos_ == end_)
+				{
+					fail();
+				}
+				if (*pos_++ == '}')
+				{
+					return;
+				}
+				if (pos_[-1] != ',')
+				{
+					fail();
+				}
+			}
+		}
+
+		template <typename Payload>
+		void Projector::add_member(rapidjson::Value&& name, rapidjson::Value& out)
+		{
+			rapidjson::Value member;
+			Projected_member<Payload>::project(*this, member);
+			out.AddMember(name, member, alloc_);
+		}
+
+		inline void Projector::value(rapidjson::Value& out)
+		{
+			rapidjson::MemoryStream stream(pos_, static_cast<std::size_t>(end_ - pos_));
+			parser_.ParseStream<rapidjson::kParseStopWhenDoneFlag>(stream);
+			if (parser_.HasParseError())
+			{
+				fail();
+			}
+			pos_ += stream.Tell();
+			out.Swap(parser_);
+		}
+
+		inline void Projector::skip_whitespace()
+		{
+			while (pos_ != end_ && (*pos_ == ' ' || *pos_ == '\n' || *pos_ == '\r' || *pos_ == '\t'))
+			{
+				++pos_;
+			}
+		}
+
+		inline void Projector::expect(char c)
+		{
+			skip_whitespace();
+			if (pos_ == end_ || *pos_ != c)
+			{
+				fail();
+			}
+			++pos_;
+		}
+
+		inline void Projector::skip_value()
+		{
+			if (pos_ == end_)
+			{
+				fail();
+			}
+			switch (*pos_)
+			{
+			case '"':
+				skip_string();
+				break;
+			case '{':
+			case '[':
+				skip_container();
+				break;
+			default:
+				// Numbers and literals end where the enclosing object continues
+				pos_ = find_first_of<',', '}', ']', ' ', '\n', '\r', '\t'>(pos_, end_);
+			}
+		}
+
+		inline void Projector::skip_string()
+		{
+			expect('"');
+			for (;;)
+			{
+				pos_ = find_first_of<'"', '\\'>(pos_, end_);
+				if (pos_ == end_)
+				{
+					fail();
+				}
+				if (*pos_ == '"')
+				{
+					++pos_;
+					return;
+				}
+				if (end_ - pos_ < 2)
+				{
+					fail();
+				}
+				pos_ += 2;
+			}
+		}
+
+		inline void Projector::skip_container()
+		{
+			std::size_t depth = 0;
+			do
+			{
+				pos_ = find_first_of<'"', '{', '}', '[', ']'>(pos_, end_);
+				if (pos_ == end_)
+				{
+					fail();
+				}
+				switch (*pos_)
+				{
+				case '"':
+					skip_string();
+					break;
+				case '{':
+				case '[':
+					++depth;
+					++pos_;
+					break;
+				default:
+					--depth;
+					++pos_;
+				}
+			} while (depth != 0);
+		}
+	}
+}
+
+#endif
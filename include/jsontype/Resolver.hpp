@@ -16,23 +16,77 @@
 #define RAPIDJSON_HAS_STDSTRING 1
 
 #include <type_traits>
+#include <functional>
 #include <unordered_map>
 #include <memory>
 #include <stdexcept>
 #include <utility>
 #include <string>
+#include <cstdint>
 #include <rapidjson/document.h>
 #include "Key.hpp"
+#include "detail/Utility.hpp"
 
 namespace jsontype
 {
+	/**
+	 * Memory taken by the nodes of a resolver, including their hash tables but not the state of their functions
+	 */
+	struct Resolver_usage
+	{
+		std::size_t nodes;
+		std::size_t bytes;
+	};
+
 	namespace detail
 	{
+		/**
+		 * Non owning reference to a member name, carrying its length and hash so that most mismatches are rejected
+		 * without comparing the characters
+		 */
+		template <typename Ch>
+		struct Name_ref
+		{
+			Name_ref(const Ch* name, std::size_t name_length)
+					: data(name), length(name_length), hash(string_hash(name, name_length)) {}
+			constexpr Name_ref(const Ch* name, std::size_t name_length, std::size_t name_hash)
+					: data(name), length(name_length), hash(name_hash) {}
+
+			template <typename Name_tag>
+			static constexpr Name_ref of() { return Name_ref(Name_tag::name(), Name_tag::length(), Name_tag::hash()); }
+
+			bool operator==(const Name_ref& other) const
+			{
+				return length == other.length
+						&& hash == other.hash
+						&& std::char_traits<Ch>::compare(data, other.data, length) == 0;
+			}
+
+			const Ch* data;
+			std::size_t length;
+			std::size_t hash;
+		};
+
+		struct Name_ref_hash
+		{
+			template <typename Ch>
+			std::size_t operator()(const Name_ref<Ch>& name) const { return name.hash; }
+		};
+
+		/**
+		 * @returns An estimate of the memory taken by the buckets and the nodes of a hash table
+		 */
+		template <typename Map>
+		std::size_t table_bytes(const Map& map)
+		{
+			return map.bucket_count() * sizeof(void*) + map.size() * (sizeof(typename Map::value_type) + 2 * sizeof(void*));
+		}
+
 		template <typename Document, typename F>
 		class Key_node
 		{
 			typedef F Func;
-			typedef std::basic_string<typename Document::Ch> Key_type;
+			typedef Name_ref<typename Document::Ch> Key_type;
 		public:
 			Key_node() = default;
 			Key_node(const F& func) : activable_(true), func_(func) {}
@@ -45,49 +99,83 @@ namespace jsontype
 			template <typename T, typename... Ts, typename std::enable_if_t<sizeof...(Ts) == 0>* = nullptr>
 			void add(const F&);
 
-			template <typename T,
-					typename... Ts,
-					typename... Fargs,
-					typename std::enable_if_t<sizeof...(Ts) >= 1>* = nullptr>
-			auto invoke(Fargs&&...) const;
-
-			template <typename T,
-					typename... Ts,
-					typename... Fargs,
-					typename std::enable_if_t<sizeof...(Ts) == 0>* = nullptr>
-			auto invoke(Fargs&&...) const;
+			/**
+			 * @returns The function linked to the key made of the given tags
+			 * @throws Out_of_range if the key is not found
+			 */
+			template <typename T, typename... Ts>
+			F& target() const;
 
-			template <typename... Fargs, typename... Ts, typename std::enable_if_t<sizeof...(Ts) == 0>* = nullptr>
-			auto invoke(Fargs&&...) const;
-
-			template <typename... Fargs,
-					typename U = std::result_of_t<F(Fargs...)>,
-					typename std::enable_if_t<std::is_same<U, void>::value>* = nullptr>
+			template <typename... Fargs>
 			auto scan(const Document&, Fargs&&... fargs) const;
 
-			template <typename... Fargs,
-					typename U = std::result_of_t<F(Fargs...)>,
-					typename std::enable_if_t<!std::is_same<U, void>::value>* = nullptr>
-			auto scan(const Document&, Fargs&&... fargs) const;
+			/**
+			 * Adds this node and the ones below it to the given usage
+			 */
+			void add_usage(Resolver_usage&) const;
 		private:
-			template <typename Json_ref,
-					typename... Fargs,
-					typename U = std::result_of_t<F(Fargs...)>,
-					typename std::enable_if_t<std::is_same<U, void>::value>* = nullptr>
-			std::result_of_t<F(Fargs...)> do_scan(const Json_ref&, bool& found, Fargs&&... fargs) const;
-
-			template <typename Json_ref,
-					typename... Fargs,
-					typename U = std::result_of_t<F(Fargs...)>,
-					typename std::enable_if_t<!std::is_same<U, void>::value>* = nullptr>
-			std::result_of_t<F(Fargs...)> do_scan(const Json_ref&, bool& found, Fargs&&... fargs) const;
+			// Nodes reached by the value of a member, rather than by its presence
+			struct Value_table
+			{
+				std::unordered_map<Key_type, std::unique_ptr<Key_node>, Name_ref_hash> strings;
+				std::unordered_map<std::int64_t, std::unique_ptr<Key_node>> integers;
+			};
+
+			template <typename T, typename... Ts, typename std::enable_if_t<sizeof...(Ts) >= 1>* = nullptr>
+			Key_node* find() const;
+
+			template <typename T, typename... Ts, typename std::enable_if_t<sizeof...(Ts) == 0>* = nullptr>
+			Key_node* find() const;
+
+			template <typename T>
+			Key_node& emplace_child(Name_element);
+
+			template <typename T>
+			Key_node& emplace_child(String_element);
+
+			template <typename T>
+			Key_node& emplace_child(Int_element);
+
+			template <typename T>
+			Key_node* find_child(Name_element) const;
+
+			template <typename T>
+			Key_node* find_child(String_element) const;
+
+			template <typename T>
+			Key_node* find_child(Int_element) const;
+
+			template <typename Json_ref>
+			Key_node* match(const Json_ref&) const;
+
+			template <typename Json_ref, typename Value_ref>
+			Key_node* match_value(const Key_type& name, const Value_ref&, const Json_ref& object) const;
 
 			bool activable_ = false;
 			F func_;
-			std::unordered_map<Key_type, std::unique_ptr<Key_node>> children_;
+			// Keys point to the names of the tags, which have static storage
+			std::unordered_map<Key_type, std::unique_ptr<Key_node>, Name_ref_hash> children_;
+			std::unordered_map<Key_type, Value_table, Name_ref_hash> values_;
 		};
 	}
 
+	/**
+	 * Function linked to a key of a resolver, found once and then called directly.
+	 * Nodes of a resolver are never moved nor destroyed before the resolver itself, so the handle stays valid across
+	 * later additions; adding its key again changes the function it calls.
+	 */
+	template <typename F>
+	class Resolver_handle
+	{
+	public:
+		explicit Resolver_handle(F& func) : func_(&func) {}
+
+		template <typename... Fargs>
+		auto operator()(Fargs&&... fargs) const { return (*func_)(std::forward<Fargs>(fargs)...); }
+	private:
+		F* func_;
+	};
+
 	template <typename Document, typename F>
 	class Generic_resolver
 	{
@@ -108,6 +196,14 @@ namespace jsontype
 		template <typename Key, typename... Fargs>
 		auto invoke(Key&&, Fargs&&... ar) const { return invoke(typename Key::Args(), std::forward<Fargs>(ar)...); }
 
+		/**
+		 * Resolves the function linked to the given key once, for repeated invocations
+		 *
+		 * @throws Out_of_range if the key is not found
+		 */
+		template <typename Key>
+		auto handle(Key&&) const { return handle(typename Key::Args()); }
+
 		/**
 		 * Scans a json and tries to invoke the best fitting function
 		 *
@@ -122,6 +218,11 @@ namespace jsontype
 		 */
 		template <typename... Fargs>
 		auto scan(const String_type&, Fargs&&... fargs) const;
+
+		/**
+		 * @returns The number of nodes of the resolver and an estimate of the memory they take
+		 */
+		Resolver_usage memory_usage() const;
 	private:
 		template <typename... Args>
 		void add(detail::Pack<Args...>&&, const Func&);
@@ -129,12 +230,60 @@ namespace jsontype
 		template <typename... Args, typename... Fargs>
 		auto invoke(detail::Pack<Args...>&&, Fargs&&...) const;
 
+		template <typename... Args>
+		auto handle(detail::Pack<Args...>&&) const { return Resolver_handle<F>(root_.template target<Args...>()); }
+
 		detail::Key_node<Document, F> root_;
 	};
 
 	template <typename F>
 	using Resolver = Generic_resolver<rapidjson::Document, F>;
 
+	template <typename Document, typename Signature>
+	class Generic_typed_resolver;
+
+	/**
+	 * Resolver whose functions receive the scanned json as a root of the type declared along with their key.
+	 * The json is parsed once: the matching function's root takes over the scanned document.
+	 */
+	template <typename Document, typename R, typename... Args>
+	class Generic_typed_resolver<Document, R(Args...)>
+	{
+		typedef std::basic_string<typename Document::Ch> String_type;
+		typedef std::function<R(Document&, Args...)> Func;
+	public:
+		/**
+		 * Add a mapping <key, function>; the function is called with a Root built from the scanned document
+		 */
+		template <typename Root, typename Key, typename Handler>
+		void add(Key&&, Handler handler);
+
+		/**
+		 * Scans a json and invokes the best fitting function, passing it the json as a root
+		 *
+		 * @throws Out_of_range if no matching key is found, Bad_structure if the json's structure is not compatible
+		 * with the function's root
+		 */
+		R scan(Document&& doc, Args... args) const;
+		/**
+		 * Parses a raw string, then scans it and invokes the best fitting function, passing it the json as a root
+		 *
+		 * @throws Runtime_error if the string is not a valid json, out_of_range if no matching key is found,
+		 * Bad_structure if the json's structure is not compatible with the function's root
+		 */
+		R scan(const String_type&, Args... args) const;
+
+		/**
+		 * @returns The number of nodes of the resolver and an estimate of the memory they take
+		 */
+		Resolver_usage memory_usage() const { return resolver_.memory_usage(); }
+	private:
+		Generic_resolver<Document, Func> resolver_;
+	};
+
+	template <typename Signature>
+	using Typed_resolver = Generic_typed_resolver<rapidjson::Document, Signature>;
+
 	//
 	// Definitions
 	//
@@ -150,7 +299,7 @@ namespace jsontype
 	template <typename... Args, typename... Fargs>
 	auto Generic_resolver<Document, F>::invoke(detail::Pack<Args...>&&, Fargs&&... fargs) const
 	{
-		return root_.template invoke<Fargs..., Args...>(std::forward<Fargs>(fargs)...);
+		return root_.template target<Args...>()(std::forward<Fargs>(fargs)...);
 	}
 
 	template <typename Document, typename F>
@@ -173,6 +322,42 @@ namespace jsontype
 		return scan(doc, std::forward<Fargs>(fargs)...);
 	}
 
+	template <typename Document, typename F>
+	Resolver_usage Generic_resolver<Document, F>::memory_usage() const
+	{
+		Resolver_usage usage{0, sizeof(root_)};
+		root_.add_usage(usage);
+		return usage;
+	}
+
+	template <typename Document, typename R, typename... Args>
+	template <typename Root, typename Key, typename Handler>
+	void Generic_typed_resolver<Document, R(Args...)>::add(Key&& key, Handler handler)
+	{
+		resolver_.add(std::forward<Key>(key), [handler](Document& doc, Args... args) mutable -> R
+		{
+			return handler(Root(std::move(doc)), std::forward<Args>(args)...);
+		});
+	}
+
+	template <typename Document, typename R, typename... Args>
+	R Generic_typed_resolver<Document, R(Args...)>::scan(Document&& doc, Args... args) const
+	{
+		return resolver_.scan(doc, doc, std::forward<Args>(args)...);
+	}
+
+	template <typename Document, typename R, typename... Args>
+	R Generic_typed_resolver<Document, R(Args...)>::scan(const String_type& str, Args... args) const
+	{
+		Document doc;
+		doc.Parse(str);
+		if (!doc.IsObject())
+		{
+			throw std::runtime_error("Cannot parse string as json: " + str);
+		}
+		return scan(std::move(doc), std::forward<Args>(args)...);
+	}
+
 	namespace detail
 	{
 		template <typename Document, typename F>
@@ -182,140 +367,232 @@ namespace jsontype
 			activable_ = true;
 		}
 
+		template <typename Document, typename F>
+		void Key_node<Document, F>::add_usage(Resolver_usage& usage) const
+		{
+			++usage.nodes;
+			usage.bytes += table_bytes(children_) + table_bytes(values_);
+			for (const auto& child : children_)
+			{
+				usage.bytes += sizeof(Key_node);
+				child.second->add_usage(usage);
+			}
+			for (const auto& table : values_)
+			{
+				usage.bytes += table_bytes(table.second.strings) + table_bytes(table.second.integers);
+				for (const auto& child : table.second.strings)
+				{
+					usage.bytes += sizeof(Key_node);
+					child.second->add_usage(usage);
+				}
+				for (const auto& child : table.second.integers)
+				{
+					usage.bytes += sizeof(Key_node);
+					child.second->add_usage(usage);
+				}
+			}
+		}
+
 		template <typename Document, typename F>
 		template <typename T, typename... Ts, typename std::enable_if_t<sizeof...(Ts) >= 1>*>
 		void Key_node<Document, F>::add(const F& f)
 		{
-			auto pair = children_.emplace(std::piecewise_construct,
-					 std::forward_as_tuple(T::name()),
-					 std::forward_as_tuple(std::make_unique<Key_node<Document, F>>()));
-			pair.first->second->template add<Ts...>(f);
+			emplace_child<T>(typename Key_element<T>::type{}).template add<Ts...>(f);
 		}
 
 		template <typename Document, typename F>
 		template <typename T, typename... Ts, typename std::enable_if_t<sizeof...(Ts) == 0>*>
 		void Key_node<Document, F>::add(const F& f)
 		{
-			auto pair = children_.emplace(std::piecewise_construct,
-					 std::forward_as_tuple(T::name()),
-					 std::forward_as_tuple(std::make_unique<Key_node<Document, F>>()));
-			pair.first->second->activate(f);
+			emplace_child<T>(typename Key_element<T>::type{}).activate(f);
 		}
 
 		template <typename Document, typename F>
-		template <typename T, typename... Ts, typename... Fargs, typename std::enable_if_t<sizeof...(Ts) >= 1>*>
-		auto Key_node<Document, F>::invoke(Fargs&&... fargs) const
+		template <typename T, typename... Ts>
+		F& Key_node<Document, F>::target() const
 		{
-			const auto it = children_.find(T::name());
-			if (it == children_.cend())
+			const auto node = find<T, Ts...>();
+			if (!node || !node->activable_)
 			{
 				throw std::out_of_range("Key not found!");
 			}
-			return it->second->template invoke<Ts...>(std::forward<Fargs>(fargs)...);
+			return node->func_;
 		}
 
 		template <typename Document, typename F>
-		template <typename T, typename... Ts, typename... Fargs, typename std::enable_if_t<sizeof...(Ts) == 0>*>
-		auto Key_node<Document, F>::invoke(Fargs&&... fargs) const
+		template <typename T, typename... Ts, typename std::enable_if_t<sizeof...(Ts) >= 1>*>
+		auto Key_node<Document, F>::find() const -> Key_node*
+		{
+			const auto node = find_child<T>(typename Key_element<T>::type{});
+			return node ? node->template find<Ts...>() : nullptr;
+		}
+
+		template <typename Document, typename F>
+		template <typename T, typename... Ts, typename std::enable_if_t<sizeof...(Ts) == 0>*>
+		auto Key_node<Document, F>::find() const -> Key_node*
 		{
-			const auto it = children_.find(T::name());
-			if (it == children_.cend() || !it->second->activable_)
+			return find_child<T>(typename Key_element<T>::type{});
+		}
+
+		template <typename Document, typename F>
+		template <typename T>
+		auto Key_node<Document, F>::emplace_child(Name_element) -> Key_node&
+		{
+			auto& child = children_[Key_type::template of<T>()];
+			if (!child)
 			{
-				throw std::out_of_range("Key not found!");
+				child = std::make_unique<Key_node>();
 			}
-			return it->second->func_(std::forward<Fargs>(fargs)...);
+			return *child;
 		}
 
 		template <typename Document, typename F>
-		template <typename... Fargs, typename U, typename std::enable_if_t<std::is_same<U, void>::value>*>
-		auto Key_node<Document, F>::scan(const Document& doc, Fargs&&... fargs) const
+		template <typename T>
+		auto Key_node<Document, F>::emplace_child(String_element) -> Key_node&
 		{
-			bool found = false;
-			do_scan(doc, found, std::forward<Fargs>(fargs)...);
-			if (!found)
+			auto& child = values_[Key_type::template of<T>()].strings[Key_type::template of<typename T::value_tag>()];
+			if (!child)
 			{
-				throw std::out_of_range("No matching key found!");
+				child = std::make_unique<Key_node>();
+			}
+			return *child;
+		}
+
+		template <typename Document, typename F>
+		template <typename T>
+		auto Key_node<Document, F>::emplace_child(Int_element) -> Key_node&
+		{
+			auto& child = values_[Key_type::template of<T>()].integers[T::value()];
+			if (!child)
+			{
+				child = std::make_unique<Key_node>();
+			}
+			return *child;
+		}
+
+		template <typename Document, typename F>
+		template <typename T>
+		auto Key_node<Document, F>::find_child(Name_element) const -> Key_node*
+		{
+			constexpr auto key = Key_type::template of<T>();
+			const auto it = children_.find(key);
+			return it != children_.cend() ? it->second.get() : nullptr;
+		}
+
+		template <typename Document, typename F>
+		template <typename T>
+		auto Key_node<Document, F>::find_child(String_element) const -> Key_node*
+		{
+			constexpr auto key = Key_type::template of<T>();
+			constexpr auto value = Key_type::template of<typename T::value_tag>();
+			const auto table = values_.find(key);
+			if (table == values_.cend())
+			{
+				return nullptr;
+			}
+			const auto it = table->second.strings.find(value);
+			return it != table->second.strings.cend() ? it->second.get() : nullptr;
+		}
+
+		template <typename Document, typename F>
+		template <typename T>
+		auto Key_node<Document, F>::find_child(Int_element) const -> Key_node*
+		{
+			constexpr auto key = Key_type::template of<T>();
+			const auto table = values_.find(key);
+			if (table == values_.cend())
+			{
+				return nullptr;
 			}
+			const auto it = table->second.integers.find(T::value());
+			return it != table->second.integers.cend() ? it->second.get() : nullptr;
 		}
 
 		template <typename Document, typename F>
-		template <typename... Fargs, typename U, typename std::enable_if_t<!std::is_same<U, void>::value>*>
+		template <typename... Fargs>
 		auto Key_node<Document, F>::scan(const Document& doc, Fargs&&... fargs) const
 		{
-			bool found = false;
-			const auto ret = do_scan(doc, found, std::forward<Fargs>(fargs)...);
-			if (!found)
+			const auto node = match(doc);
+			if (!node)
 			{
 				throw std::out_of_range("No matching key found!");
 			}
-			return ret;
+			return node->func_(std::forward<Fargs>(fargs)...);
 		}
 
+		/**
+		 * @returns The deepest activable node matching the members of the given object, nullptr if there's none
+		 */
 		template <typename Document, typename F>
-		template <typename Json_ref,
-				typename... Fargs,
-				typename U,
-				typename std::enable_if_t<std::is_same<U, void>::value>*>
-		auto Key_node<Document, F>::do_scan(const Json_ref& ref, bool& found, Fargs&&... fargs) const
-				-> std::result_of_t<F(Fargs...)>
+		template <typename Json_ref>
+		auto Key_node<Document, F>::match(const Json_ref& ref) const -> Key_node*
 		{
 			for (auto& member : ref.GetObject())
 			{
-				const auto it = children_.find(member.name.GetString());
+				const Key_type name(member.name.GetString(), member.name.GetStringLength());
+				const auto value_node = match_value(name, member.value, ref);
+				if (value_node)
+				{
+					return value_node;
+				}
+				const auto it = children_.find(name);
 				if (it == children_.cend())
 				{
 					continue;
 				}
-				bool found_child = false;
 				if (member.value.IsObject())
 				{
-					it->second->do_scan(member.value, found_child, std::forward<Fargs>(fargs)...);
-					if (found_child)
+					const auto node = it->second->match(member.value);
+					if (node)
 					{
-						found = true;
-						return;
+						return node;
 					}
 				}
 				if (it->second->activable_)
 				{
-					found = true;
-					return it->second->func_(std::forward<Fargs>(fargs)...);
+					return it->second.get();
 				}
 			}
+			return nullptr;
 		}
 
+		/**
+		 * Looks up the value of a member in the value tables; the elements following a value in a key are
+		 * matched against the same object
+		 *
+		 * @returns The deepest activable node reached through the value, nullptr if there's none
+		 */
 		template <typename Document, typename F>
-		template <typename Json_ref,
-				typename... Fargs,
-				typename U,
-				typename std::enable_if_t<!std::is_same<U, void>::value>*>
-		auto Key_node<Document, F>::do_scan(const Json_ref& ref, bool& found, Fargs&&... fargs) const
-				-> std::result_of_t<F(Fargs...)>
+		template <typename Json_ref, typename Value_ref>
+		auto Key_node<Document, F>::match_value(const Key_type& name, const Value_ref& value, const Json_ref& object) const
+				-> Key_node*
 		{
-			for (auto& member : ref.GetObject())
+			if (values_.empty())
 			{
-				const auto it = children_.find(member.name.GetString());
-				if (it == children_.cend())
-				{
-					continue;
-				}
-				bool found_child = false;
-				if (member.value.IsObject())
-				{
-					const auto ret = it->second->do_scan(member.value, found_child, std::forward<Fargs>(fargs)...);
-					if (found_child)
-					{
-						found = true;
-						return ret;
-					}
-				}
-				if (it->second->activable_)
-				{
-					found = true;
-					return it->second->func_(std::forward<Fargs>(fargs)...);
-				}
+				return nullptr;
+			}
+			const auto table = values_.find(name);
+			if (table == values_.cend())
+			{
+				return nullptr;
+			}
+			Key_node* node = nullptr;
+			if (value.IsString())
+			{
+				const auto it = table->second.strings.find(Key_type(value.GetString(), value.GetStringLength()));
+				node = it != table->second.strings.cend() ? it->second.get() : nullptr;
+			}
+			else if (value.IsInt64())
+			{
+				const auto it = table->second.integers.find(value.GetInt64());
+				node = it != table->second.integers.cend() ? it->second.get() : nullptr;
+			}
+			if (!node)
+			{
+				return nullptr;
 			}
-			return std::result_of_t<F(Fargs...)>{};
+			const auto deeper = node->match(object);
+			return deeper ? deeper : (node->activable_ ? node : nullptr);
 		}
 	}
 }
@@ -20,30 +20,143 @@
 #include <type_traits>
 #include <utility>
 #include <cassert>
+#include <cstring>
 #include <stdexcept>
 #include <tuple>
+#include <atomic>
+#include <future>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <functional>
 #include <rapidjson/document.h>
 #include <rapidjson/writer.h>
 #include <rapidjson/stringbuffer.h>
+#include <rapidjson/reader.h>
+#include <rapidjson/memorystream.h>
+#include <rapidjson/encodedstream.h>
 #include "Key.hpp"
+#include "Output_stream.hpp"
+#include "String_pool.hpp"
 #include "detail/Value_traits.hpp"
 #include "detail/Encoding_traits.hpp"
 #include "detail/Utility.hpp"
+#include "detail/Fragment_cache.hpp"
+#include "detail/Mapped_file.hpp"
+#include "detail/Phase_counters.hpp"
+
+#ifndef JSONTYPE_PARALLEL_CHECK_THRESHOLD
+// Elements of a typed array checked by each thread of a structure check
+#define JSONTYPE_PARALLEL_CHECK_THRESHOLD 8192
+#endif
 
 namespace jsontype
 {
+	template <typename Name_tag, typename... Payloads>
+	class Object;
+
+	template <typename Document>
+	class Tracked_document;
+
+	template <typename Document>
+	class Interned_document;
+
+	template <typename Document>
+	class Timed_document;
+
+	template <typename Document>
+	class Counted_document;
+
+	struct Root_counters;
+
 	namespace detail
 	{
 		struct No_name_tag : Tag<No_name_tag> { static constexpr auto name() { return "No_name"; } };
 		struct Const_alloc {};
+		struct Unchecked {};
+		struct Member_layout;
+
+		template <typename Encoding, typename Allocator, typename Stack_allocator>
+		rapidjson::GenericDocument<Encoding, Allocator, Stack_allocator> plain_document(
+				const rapidjson::GenericDocument<Encoding, Allocator, Stack_allocator>&);
+
+		// The rapidjson document which a document type is or derives from, with the same allocators
+		template <typename Document>
+		using Plain_document = decltype(plain_document(std::declval<const Document&>()));
 
 		struct Build_worker;
 		struct Structure_check_worker;
+		struct Fragment_worker;
 
 		struct Finder;
 
+		template <typename... Element>
+		struct Array_elements;
+
+		// Whether the element of an array is an Object or is left undeclared
+		template <typename... Element>
+		struct Is_element : std::false_type {};
+
+		template <>
+		struct Is_element<> : std::true_type {};
+
+		template <typename Name_tag, typename... Payloads>
+		struct Is_element<Object<Name_tag, Payloads...>> : std::true_type {};
+
 		template <typename Json_ref>
 		typename Character_traits<typename Json_ref::Ch>::String_type do_stringify(const Json_ref&);
+
+		template <typename Json_ref, typename Output_stream>
+		void write_json(const Json_ref&, Output_stream&);
+
+		template <typename Json_ref, typename Ch>
+		std::size_t write_json(const Json_ref&, Ch*, std::size_t);
+
+		template <typename Document>
+		auto& proxy_alloc(Document&);
+
+		template <typename Document>
+		auto& proxy_alloc(Tracked_document<Document>&);
+
+		template <typename Document>
+		auto& proxy_alloc(Interned_document<Document>&);
+
+		template <typename Document>
+		auto& proxy_alloc(Timed_document<Document>&);
+
+		template <typename Schema, typename Document>
+		void bind_phases(Document&);
+
+		template <typename Schema, typename Document>
+		void bind_phases(Timed_document<Document>&);
+
+		template <typename Schema, typename Document, typename F>
+		auto measure(const Document&, Root_phase, F&& f);
+
+		template <typename Schema, typename Document, typename F>
+		auto measure(const Timed_document<Document>&, Root_phase, F&& f);
+
+		template <typename Document>
+		void count_creation(Document&, Root_counters&);
+
+		template <typename Document>
+		void count_creation(Counted_document<Document>&, Root_counters&);
+
+		/**
+		 * Allocator given to the proxies of a timed document, which measures the values set through them
+		 */
+		template <typename Allocator>
+		class Timed_alloc
+		{
+		public:
+			void bind(Allocator& alloc) { alloc_ = &alloc; }
+			void bind(Phase_counters& (*counters)()) { counters_ = counters; }
+			Allocator& allocator() const { return *alloc_; }
+			Phase_counters& counters() const { return counters_(); }
+		private:
+			Allocator* alloc_ = nullptr;
+			Phase_counters& (*counters_)() = nullptr;
+		};
 	}
 
 	template <typename Payload, typename Json_ref, typename Alloc>
@@ -65,7 +178,7 @@ namespace jsontype
 		auto stringify() const { return detail::do_stringify(document_); }
 	protected:
 		Generic_basic_root() { document_.SetObject(); }
-		Generic_basic_root(rapidjson::Document&& doc) : document_(std::move(doc)) {}
+		Generic_basic_root(detail::Plain_document<Document>&& doc) : document_(std::move(doc)) {}
 		Generic_basic_root(Generic_basic_root&&) = default;
 		~Generic_basic_root() = default;
 		Generic_basic_root& operator=(Generic_basic_root&&) = default;
@@ -75,6 +188,136 @@ namespace jsontype
 		Document document_;
 	};
 
+	/**
+	 * Json document which caches the serialized form of its objects.
+	 * Objects whose values were not modified through a proxy since the last serialization are not serialized
+	 * again, their cached fragment is used instead.
+	 */
+	template <typename Document>
+	class Tracked_document : public Document
+	{
+	public:
+		using Fragment_cache = detail::Fragment_cache<typename Document::AllocatorType, typename Document::Ch>;
+
+		Tracked_document() = default;
+		Tracked_document(Document&& doc) : Document(std::move(doc)) {}
+		Tracked_document(Tracked_document&&) = default;
+		Tracked_document& operator=(Tracked_document&&) = default;
+
+		auto& fragment_cache() { cache_.bind(this->GetAllocator()); return cache_; }
+		auto& fragment_cache() const { return cache_; }
+	private:
+		mutable Fragment_cache cache_;
+	};
+
+	/**
+	 * Json document whose strings are kept in the pool shared by all the interned documents.
+	 * Strings repeated across many documents are stored once, each document only refers to them.
+	 */
+	template <typename Document>
+	class Interned_document : public Document
+	{
+	public:
+		using Ch = typename Document::Ch;
+		using String_interner = detail::String_interner<typename Document::AllocatorType, Ch>;
+
+		Interned_document() : interner_(String_pool<Ch>::shared()) {}
+		Interned_document(Document&& doc) : Document(std::move(doc)), interner_(String_pool<Ch>::shared())
+		{
+			string_interner().intern_all(*this);
+		}
+		Interned_document(Interned_document&&) = default;
+		Interned_document& operator=(Interned_document&&) = default;
+
+		/**
+		 * Parses a json, looking up its strings in the pool instead of copying them into the document
+		 */
+		Interned_document& Parse(const std::basic_string<Ch>& json) { return Parse(json.data(), json.size()); }
+		Interned_document& Parse(const Ch* json, std::size_t length);
+
+		auto& string_interner() { interner_.bind(this->GetAllocator()); return interner_; }
+		const auto& string_interner() const { return interner_; }
+	private:
+		String_interner interner_;
+	};
+
+	/**
+	 * Json document whose roots measure the time spent parsing, checking, finding, setting and serializing.
+	 * The cycles are added to per-thread counters of the root's type, read by the root's phase_statistics()
+	 */
+	template <typename Document>
+	class Timed_document : public Document
+	{
+	public:
+		using Timed_alloc = detail::Timed_alloc<typename Document::AllocatorType>;
+
+		Timed_document() = default;
+		Timed_document(Document&& doc) : Document(std::move(doc)) {}
+		Timed_document(Timed_document&&) = default;
+		Timed_document& operator=(Timed_document&&) = default;
+
+		auto& timed_alloc() { alloc_.bind(this->GetAllocator()); return alloc_; }
+	private:
+		Timed_alloc alloc_;
+	};
+
+	/**
+	 * Memory held by the allocator of a document, in bytes
+	 */
+	struct Memory_usage
+	{
+		std::size_t reserved;
+		std::size_t used;
+		std::size_t live;
+		// Bytes handed out to values which are no longer reachable, such as overwritten strings
+		std::size_t lost;
+	};
+
+	/**
+	 * Roots of a type created so far and still alive, along with the memory their allocators reserved when they
+	 * were created. Only the roots of a Counted_document update them, otherwise they stay at zero
+	 */
+	struct Root_counters
+	{
+		std::atomic<std::size_t> created{0};
+		std::atomic<std::size_t> alive{0};
+		std::atomic<std::size_t> reserved{0};
+	};
+
+	/**
+	 * Json document whose roots are counted in the Root_counters of their type.
+	 * A moved from document is still destroyed, so moving counts as a new live root but not as a creation
+	 */
+	template <typename Document>
+	class Counted_document : public Document
+	{
+	public:
+		Counted_document() = default;
+		Counted_document(Document&& doc) : Document(std::move(doc)) {}
+		Counted_document(Counted_document&& other) : Document(std::move(other)), counters_(other.counters_)
+		{
+			if (counters_)
+			{
+				++counters_->alive;
+			}
+		}
+		~Counted_document()
+		{
+			if (counters_)
+			{
+				--counters_->alive;
+			}
+		}
+		Counted_document& operator=(Counted_document&& other);
+
+		/**
+		 * Counts the creation of this document's root in the given counters
+		 */
+		void count(Root_counters& counters);
+	private:
+		Root_counters* counters_ = nullptr;
+	};
+
 	/**
 	 * Root of a json entity.
 	 * It maps compile times defined types over a json document; it allows concise definition of a fixed structure,
@@ -85,8 +328,10 @@ namespace jsontype
 	{
 		friend struct detail::Build_worker;
 		friend struct detail::Structure_check_worker;
+		friend struct detail::Fragment_worker;
 		friend struct detail::Finder;
 		using Base = Generic_basic_root<Document>;
+		using Plain_document = detail::Plain_document<Document>;
 	public:
 		/**
 		 * Creates a json document with all fields defaulted
@@ -98,12 +343,59 @@ namespace jsontype
 		 * @throws Bad_structure if the json string's structure is not compatible with this type
 		 */
 		explicit Generic_root(const std::basic_string<typename Document::Ch>&);
+		/**
+		 * Creates a json document and populates all fields with the values parsed from the given json characters
+		 *
+		 * @throws Bad_structure if the json's structure is not compatible with this type
+		 */
+		Generic_root(const typename Document::Ch*, std::size_t length);
 		/**
 		 * Initializes a new object using the given document as its basis.
 		 *
 		 * @throws Bad_structure if the document's structure is not compatible with this type
 		 */
-		explicit Generic_root(rapidjson::Document&&);
+		explicit Generic_root(Plain_document&&);
+
+		/**
+		 * Creates a json document by parsing the content of a file, which is memory mapped rather than read
+		 *
+		 * @throws std::system_error if the file can't be read, Bad_structure if its structure is not compatible with this type
+		 */
+		static Generic_root from_file(const std::string& path);
+
+		/**
+		 * @returns Whether every member sits at the position of its declaration, as in the documents jsontype builds.
+		 * Lookups in such a document never fall back to a search by name
+		 */
+		bool canonical() const;
+
+		/**
+		 * @returns A deep copy of this object, made without serializing it or checking its structure again
+		 */
+		Generic_root clone() const;
+
+		/**
+		 * @returns The memory reserved by the document's allocator, the part of it handed out to values and the part
+		 * still reachable from the document. Finding the reachable part costs about as much as a clone
+		 */
+		Memory_usage memory_usage() const;
+
+		/**
+		 * Moves the document into a new allocator holding only the reachable values, releasing the memory left
+		 * behind by overwritten ones. Proxies obtained before are invalidated
+		 */
+		void compact();
+
+		/**
+		 * @returns The counters shared by all the roots of this type. Only counted roots update them
+		 */
+		static const Root_counters& memory_counters() { return counters(); }
+
+		/**
+		 * @returns The calls and cycles spent in each phase by the roots of this type on all threads. Only
+		 * timed roots record them
+		 */
+		static Phase_statistics phase_statistics() { return detail::Phase_registry<Generic_root>::snapshot(); }
 
 		template <typename Name_tag>
 		auto find(Name_tag);
@@ -131,11 +423,84 @@ namespace jsontype
 		 * @returns A reference to the underlying rapidjson object
 		 */
 		const auto& ref() const { return Base::document(); }
-		using Base::stringify;
+		/**
+		 * @returns A json string representation of this object
+		 */
+		auto stringify() const { return measure(Root_phase::stringify, [this] { return stringify(document()); }); }
+		/**
+		 * Writes the json representation of this object into the given rapidjson output stream
+		 */
+		template <typename Output_stream>
+		void stringify_to(Output_stream& os) const
+		{
+			measure(Root_phase::stringify, [&] { write(document(), os); });
+		}
+		/**
+		 * Writes the json representation of this object into the given buffer, without a terminating null
+		 *
+		 * @returns The length of the json representation, the output is truncated if it's greater than size
+		 */
+		template <typename Ch>
+		std::size_t stringify_to(Ch* data, std::size_t size) const;
 	private:
+		Generic_root(detail::Unchecked, Plain_document&& doc) : Base(std::move(doc)) { count_creation(); }
+
+		/**
+		 * @returns The document with all fields defaulted, built the first time it's needed
+		 */
+		static const Plain_document& prototype();
+
+		static Root_counters& counters()
+		{
+			static Root_counters counters;
+			return counters;
+		}
+
+		void count_creation();
+
 		auto& document() { return Base::document(); }
+		auto& proxy_alloc() { detail::bind_phases<Generic_root>(document()); return detail::proxy_alloc(document()); }
 		void structure_check();
 
+		template <typename Name_tag>
+		auto lookup(Name_tag);
+
+		template <typename Name_tag>
+		auto lookup(Name_tag) const;
+
+		template <typename K>
+		auto lookup(detail::Pack<K>) { return lookup(K{}); }
+
+		template <typename K>
+		auto lookup(detail::Pack<K>) const { return lookup(K{}); }
+
+		template <typename K, typename Next, typename... Ks>
+		auto lookup(detail::Pack<K, Next, Ks...>);
+
+		template <typename K, typename Next, typename... Ks>
+		auto lookup(detail::Pack<K, Next, Ks...>) const;
+
+		template <typename F>
+		auto measure(Root_phase phase, F&& f) const
+		{
+			return detail::measure<Generic_root>(document(), phase, std::forward<F>(f));
+		}
+
+		template <typename Json_ref>
+		static auto stringify(const Json_ref& ref) { return detail::do_stringify(ref); }
+
+		template <typename Base_document>
+		static auto stringify(const Tracked_document<Base_document>&);
+
+		template <typename Json_ref, typename Output_stream>
+		static void write(const Json_ref& ref, Output_stream& os) { detail::write_json(ref, os); }
+
+		template <typename Base_document, typename Output_stream>
+		static void write(const Tracked_document<Base_document>&, Output_stream&);
+
+		template <typename Base_document>
+		static auto refresh_fragments(const Tracked_document<Base_document>&);
+
 		template <typename Json_ref, typename Alloc, typename F, typename T, typename... Ts>
 		static void expand(Json_ref&, Alloc&, const F& = F());
 
@@ -147,6 +512,22 @@ namespace jsontype
 	template <typename... Payloads>
 	using Root = Generic_root<rapidjson::Document, Payloads...>;
 
+	// Shortcut for a rapidjson::Document with serialization caching
+	template <typename... Payloads>
+	using Tracked_root = Generic_root<Tracked_document<rapidjson::Document>, Payloads...>;
+
+	// Shortcut for a rapidjson::Document with strings interned in a shared pool
+	template <typename... Payloads>
+	using Interned_root = Generic_root<Interned_document<rapidjson::Document>, Payloads...>;
+
+	// Shortcut for a rapidjson::Document measuring the phases of its roots
+	template <typename... Payloads>
+	using Timed_root = Generic_root<Timed_document<rapidjson::Document>, Payloads...>;
+
+	// Shortcut for a rapidjson::Document counting its roots
+	template <typename... Payloads>
+	using Counted_root = Generic_root<Counted_document<rapidjson::Document>, Payloads...>;
+
 	/**
 	 * Represents a composable json object that can be either a leaf or a node in the document's hierarchy
 	 */
@@ -157,6 +538,10 @@ namespace jsontype
 
 		friend struct detail::Build_worker;
 		friend struct detail::Structure_check_worker;
+		friend struct detail::Fragment_worker;
+
+		template <typename... Element>
+		friend struct detail::Array_elements;
 
 		template <typename Payload, typename Json_ref, typename Alloc>
 		friend class Object_proxy;
@@ -179,34 +564,44 @@ namespace jsontype
 		static void build(Json_ref&, Alloc&);
 
 		template <typename Json_ref, typename Alloc>
-		static void structure_check(Json_ref&, Alloc&);
+		static void structure_check(Json_ref&, Alloc&, detail::Member_layout&);
 
-		template <typename Json_ref, typename Alloc, typename F, typename T, typename... Ts>
-		static auto expand(Json_ref&,
-				Alloc&,
-				const F& = F()) -> typename std::enable_if<!std::is_same<Name_tag, T>::value>::type;
+		/**
+		 * Checks the members of a json object against the payloads
+		 */
+		template <typename Json_ref, typename Alloc>
+		static void check_members(Json_ref&, Alloc&, detail::Member_layout&);
+
+		template <typename Json_ref, typename Cache>
+		static void refresh_fragment(const Json_ref&, Cache&);
+
+		template <typename Json_ref, typename Alloc, typename F, typename... Ts>
+		static void expand(Json_ref&, Alloc&, const F& = F());
 
 		template <typename Json_ref, typename Alloc, typename F, typename T, typename... Ts>
-		static auto expand(Json_ref&,
-				Alloc&,
-				const F& = F()) -> typename std::enable_if<std::is_same<Name_tag, T>::value>::type {}
+		static void expand_members(Json_ref&, Alloc&, const F&);
 
 		template <typename Json_ref, typename Alloc, typename F, typename... Ts>
-		static auto expand(Json_ref&,
+		static auto expand_members(Json_ref&,
 				Alloc&,
-				const F& = F()) -> typename std::enable_if<sizeof...(Ts) == 0>::type {}
+				const F&) -> typename std::enable_if<sizeof...(Ts) == 0>::type {}
 	};
 
 	/**
-	 * Represents a json array
+	 * Represents a json array. An array declared with an Object as its element must hold only objects with that
+	 * structure, which are checked along with the rest of the document; the name tag of the element object is used
+	 * in the error messages only
 	 */
-	template <typename Name_tag = detail::No_name_tag>
+	template <typename Name_tag = detail::No_name_tag, typename... Element>
 	class Array
 	{
 		static_assert(detail::is_tag<Name_tag>(), "Name tag template argument must be a tag class");
+		static_assert(sizeof...(Element) <= 1, "An array can have only one element type");
+		static_assert(detail::Is_element<Element...>::value, "The element of an array must be an Object");
 
 		friend struct detail::Build_worker;
 		friend struct detail::Structure_check_worker;
+		friend struct detail::Fragment_worker;
 
 		template <typename Payload, typename Json_ref, typename Alloc>
 		friend class Array_proxy;
@@ -223,7 +618,10 @@ namespace jsontype
 		static void build(Json_ref&, Alloc&);
 
 		template <typename Json_ref, typename Alloc>
-		static void structure_check(Json_ref&, Alloc&);
+		static void structure_check(Json_ref&, Alloc&, detail::Member_layout&);
+
+		template <typename Json_ref, typename Cache>
+		static void refresh_fragment(const Json_ref&, Cache&);
 	};
 
 	template <typename Name_tag, typename T>
@@ -232,6 +630,7 @@ namespace jsontype
 		static_assert(detail::is_tag<Name_tag>(), "Name tag template argument must be a tag class");
 
 		friend struct detail::Structure_check_worker;
+		friend struct detail::Fragment_worker;
 
 		template <typename Payload, typename Json_ref, typename Alloc>
 		friend class Value_field_proxy;
@@ -246,7 +645,10 @@ namespace jsontype
 		static T get(Json_ref& ref);
 
 		template <typename Json_ref, typename Alloc>
-		static void structure_check(Json_ref&, Alloc&);
+		static void structure_check(Json_ref&, Alloc&, detail::Member_layout&);
+
+		template <typename Json_ref, typename Cache>
+		static void refresh_fragment(const Json_ref&, Cache&) {}
 	};
 
 	/**
@@ -325,6 +727,12 @@ namespace jsontype
 		auto operator[](T tag) { return find(tag); }
 
 		auto stringify() const { return Payload::stringify(this->ref()); }
+
+		template <typename Output_stream>
+		void stringify_to(Output_stream& os) const { detail::write_json(this->ref(), os); }
+
+		template <typename Ch>
+		std::size_t stringify_to(Ch* data, std::size_t size) const { return detail::write_json(this->ref(), data, size); }
 	};
 
 	template <typename Payload, typename Json_ref, typename Alloc = detail::Const_alloc>
@@ -334,7 +742,22 @@ namespace jsontype
 	public:
 		using Base::Base_member_proxy;
 
+		std::size_t size() const { return this->ref().Size(); }
+
+		/**
+		 * @returns A proxy to the element at the given position, only for arrays with a declared element
+		 */
+		auto operator[](std::size_t index);
+
+		auto operator[](std::size_t index) const;
+
 		auto stringify() const { return Payload::stringify(this->ref()); }
+
+		template <typename Output_stream>
+		void stringify_to(Output_stream& os) const { detail::write_json(this->ref(), os); }
+
+		template <typename Ch>
+		std::size_t stringify_to(Ch* data, std::size_t size) const { return detail::write_json(this->ref(), data, size); }
 	};
 
 	template <typename Payload, typename Json_ref, typename Alloc = detail::Const_alloc>
@@ -351,6 +774,53 @@ namespace jsontype
 		Value_field_proxy& operator=(Param_type val);
 	};
 
+	/**
+	 * @returns A hash of the members described by the payloads, which doesn't depend on their order in the document
+	 */
+	template <typename Document, typename... Payloads>
+	std::size_t hash(const Generic_root<Document, Payloads...>&);
+
+	template <typename Name_tag, typename... Payloads, typename Json_ref, typename Alloc>
+	std::size_t hash(const Object_proxy<Object<Name_tag, Payloads...>, Json_ref, Alloc>&);
+
+	/**
+	 * Compares the members described by the payloads, stopping at the first one that differs
+	 */
+	template <typename Document, typename Other_document, typename... Payloads>
+	bool operator==(const Generic_root<Document, Payloads...>&, const Generic_root<Other_document, Payloads...>&);
+
+	template <typename Document, typename Other_document, typename... Payloads>
+	bool operator!=(const Generic_root<Document, Payloads...>& lhs,
+			const Generic_root<Other_document, Payloads...>& rhs)
+	{
+		return !(lhs == rhs);
+	}
+
+	template <typename Name_tag, typename... Payloads, typename Json_ref, typename Alloc, typename Other_ref, typename Other_alloc>
+	bool operator==(const Object_proxy<Object<Name_tag, Payloads...>, Json_ref, Alloc>&,
+			const Object_proxy<Object<Name_tag, Payloads...>, Other_ref, Other_alloc>&);
+
+	template <typename Payload, typename Json_ref, typename Alloc, typename Other_ref, typename Other_alloc>
+	bool operator!=(const Object_proxy<Payload, Json_ref, Alloc>& lhs,
+			const Object_proxy<Payload, Other_ref, Other_alloc>& rhs)
+	{
+		return !(lhs == rhs);
+	}
+
+	/**
+	 * Runs the chunks of the structure check of a large typed array: it must call the given function once for
+	 * each index from 0 to count - 1, from any threads, and return once all the calls returned
+	 */
+	using Check_executor = std::function<void(std::size_t count, const std::function<void(std::size_t)>& chunk)>;
+
+	/**
+	 * Hands the chunks of the structure checks of typed arrays to the given executor, such as one backed by an
+	 * existing thread pool, instead of starting a thread for each of them. Arrays are then split only by
+	 * JSONTYPE_PARALLEL_CHECK_THRESHOLD rather than by the number of cores; an empty executor restores the default.
+	 * It must not be changed while documents are being checked
+	 */
+	inline void set_check_executor(Check_executor executor);
+
 	class Bad_structure : public std::runtime_error
 	{
 	public:
@@ -382,12 +852,84 @@ namespace jsontype
 					typename Payload_finder<Name_tag, Ts...>::type>::type type;
 		};
 
+		template <typename Name_tag, typename T_name_tag, typename... T_element, typename... Ts>
+		struct Payload_finder<Name_tag, Array<T_name_tag, T_element...>, Ts...>
+		{
+			typedef typename std::conditional<std::is_same<Name_tag, T_name_tag>::value,
+					Array<T_name_tag, T_element...>,
+					typename Payload_finder<Name_tag, Ts...>::type>::type type;
+		};
+
 		template <typename Name_tag>
 		struct Payload_finder<Name_tag>
 		{
 			typedef No_result type;
 		};
 
+		template <typename T, typename... Ts> struct Payload_index;
+
+		template <typename T, typename... Ts>
+		struct Payload_index<T, T, Ts...> : std::integral_constant<std::size_t, 0> {};
+
+		template <typename T, typename U, typename... Ts>
+		struct Payload_index<T, U, Ts...> : std::integral_constant<std::size_t, 1 + Payload_index<T, Ts...>::value> {};
+
+		/**
+		 * Position of the next member expected by a structure check, and whether all the members checked so far
+		 * were found at the position of their declaration
+		 */
+		struct Member_layout
+		{
+			std::size_t position = 0;
+			bool canonical = true;
+		};
+
+		/**
+		 * Looks for the member named after the given tag, whose name length is known at compile time
+		 */
+		template <typename Name_tag, typename Json_ref>
+		auto find_member(Json_ref& ref)
+		{
+			constexpr auto length = Name_tag::length();
+			const rapidjson::GenericValue<typename Json_ref::EncodingType> name(
+					rapidjson::StringRef(Name_tag::name(), length));
+			return ref.FindMember(name);
+		}
+
+		/**
+		 * Looks for a member by name, first testing if it's the member at the given position
+		 */
+		template <typename Name_tag, typename Json_ref>
+		auto find_member(Json_ref& ref, std::size_t position)
+		{
+			constexpr auto length = Name_tag::length();
+			if (position < ref.MemberCount())
+			{
+				const auto member = ref.MemberBegin() + position;
+				if (member->name.GetStringLength() == length && std::char_traits<typename Json_ref::Ch>::compare(
+						member->name.GetString(), Name_tag::name(), length) == 0)
+				{
+					return member;
+				}
+			}
+			return find_member<Name_tag>(ref);
+		}
+
+		/**
+		 * Looks for the next member of a structure check, keeping track of the layout
+		 */
+		template <typename Name_tag, typename Json_ref>
+		auto find_member(Json_ref& ref, Member_layout& layout)
+		{
+			const auto position = layout.position++;
+			const auto member = find_member<Name_tag>(ref, position);
+			if (member != ref.MemberEnd() && static_cast<std::size_t>(member - ref.MemberBegin()) != position)
+			{
+				layout.canonical = false;
+			}
+			return member;
+		}
+
 		template <typename T>
 		struct Member_proxy_traits
 		{
@@ -406,26 +948,93 @@ namespace jsontype
 
 		struct Structure_check_worker
 		{
+			Member_layout& layout;
+
 			template <typename Owner, typename Json_ref, typename Alloc, typename T>
 			void operator()(Json_ref& ref, Alloc& alloc) const
 			{
-				T::structure_check(ref, alloc);
+				T::structure_check(ref, alloc, layout);
 			}
 		};
 
-		struct Finder
+		struct Fragment_worker
 		{
-			template <typename Origin, typename Json_ref, typename Alloc, typename Name_tag, typename... Payloads>
-			auto operator()(Json_ref& ref, Alloc& alloc) const
+			template <typename Owner, typename Json_ref, typename Cache, typename T>
+			void operator()(const Json_ref& ref, Cache& cache) const
 			{
-				using Member = typename detail::Payload_finder<Name_tag, Payloads...>::type;
-				static_assert(!std::is_same<Member, No_result>::value, "Can't find any member with the given name tag");
+				T::refresh_fragment(ref, cache);
+			}
+		};
 
-				auto json_handle = ref.FindMember(Name_tag::name());
-				assert(json_handle != ref.MemberEnd());
+		template <typename Document>
+		auto& proxy_alloc(Document& doc) { return doc.GetAllocator(); }
 
-				using Proxy_object = typename detail::Member_proxy_traits<Member>::template Proxy_category<Member,
-						decltype(json_handle->value), decltype(alloc)>;
+		template <typename Document>
+		auto& proxy_alloc(Tracked_document<Document>& doc) { return doc.fragment_cache(); }
+
+		template <typename Document>
+		auto& proxy_alloc(Interned_document<Document>& doc) { return doc.string_interner(); }
+
+		template <typename Document>
+		void clear_fragments(Document&) {}
+
+		template <typename Document>
+		void clear_fragments(Tracked_document<Document>& doc) { doc.fragment_cache().clear(); }
+
+		template <typename Document>
+		auto& proxy_alloc(Timed_document<Document>& doc) { return doc.timed_alloc(); }
+
+		template <typename Schema, typename Document>
+		void bind_phases(Document&) {}
+
+		template <typename Schema, typename Document>
+		void bind_phases(Timed_document<Document>& doc) { doc.timed_alloc().bind(&Phase_registry<Schema>::local); }
+
+		template <typename Schema, typename Document, typename F>
+		auto measure(const Document&, Root_phase, F&& f) { return f(); }
+
+		template <typename Schema, typename Document, typename F>
+		auto measure(const Timed_document<Document>&, Root_phase phase, F&& f)
+		{
+			const Phase_timer timer(Phase_registry<Schema>::local(), phase);
+			return f();
+		}
+
+		template <typename Document>
+		void count_creation(Document&, Root_counters&) {}
+
+		template <typename Document>
+		void count_creation(Counted_document<Document>& doc, Root_counters& counters) { doc.count(counters); }
+
+		template <typename Allocator>
+		Allocator& base_alloc(Timed_alloc<Allocator>& alloc) { return alloc.allocator(); }
+
+		template <typename T, typename Json_ref, typename Allocator, typename Value>
+		void set_value(Json_ref& ref, Timed_alloc<Allocator>& alloc, const Value& value)
+		{
+			const Phase_timer timer(alloc.counters(), Root_phase::set);
+			Value_traits<T>::set(ref, alloc.allocator(), value);
+		}
+
+		template <typename T, typename Json_ref, typename Alloc, typename Value>
+		void set_value(Json_ref& ref, Alloc& alloc, const Value& value)
+		{
+			Value_traits<T>::set(ref, base_alloc(alloc), value);
+		}
+
+		struct Finder
+		{
+			template <typename Origin, typename Json_ref, typename Alloc, typename Name_tag, typename... Payloads>
+			auto operator()(Json_ref& ref, Alloc& alloc) const
+			{
+				using Member = typename detail::Payload_finder<Name_tag, Payloads...>::type;
+				static_assert(!std::is_same<Member, No_result>::value, "Can't find any member with the given name tag");
+
+				auto json_handle = find_member<Name_tag>(ref, Payload_index<Member, Payloads...>::value);
+				assert(json_handle != ref.MemberEnd());
+
+				using Proxy_object = typename detail::Member_proxy_traits<Member>::template Proxy_category<Member,
+						decltype(json_handle->value), decltype(alloc)>;
 				return Proxy_object(json_handle->value, alloc);
 			}
 
@@ -435,7 +1044,7 @@ namespace jsontype
 				using Member = typename detail::Payload_finder<Name_tag, Payloads...>::type;
 				static_assert(!std::is_same<Member, No_result>::value, "Can't find any member with the given name tag");
 
-				auto json_handle = ref.FindMember(Name_tag::name());
+				auto json_handle = find_member<Name_tag>(ref, Payload_index<Member, Payloads...>::value);
 				assert(json_handle != ref.MemberEnd());
 
 				using Proxy_object = typename detail::Member_proxy_traits<Member>::template Proxy_category<Member,
@@ -485,37 +1094,363 @@ namespace jsontype
 			}
 		};
 
+		template <typename Payload> struct Element_of;
+
+		template <typename Payload> struct Element_count;
+
+		template <typename Name_tag, typename... Element>
+		struct Element_count<Array<Name_tag, Element...>> : std::integral_constant<std::size_t, sizeof...(Element)> {};
+
+		template <typename Name_tag, typename Element>
+		struct Element_of<Array<Name_tag, Element>>
+		{
+			typedef Element type;
+		};
+
+		/**
+		 * Checks and serializes the elements of arrays, which have a structure only if the array declares it
+		 */
+		template <typename... Element>
+		struct Array_elements
+		{
+			template <typename Json_ref, typename Alloc>
+			static void check(Json_ref&, Alloc&, Member_layout&, const char*) {}
+
+			template <typename Array_tag, typename Json_ref, typename Cache>
+			static void refresh_fragment(const Json_ref&, Cache&) {}
+		};
+
+		template <typename Name_tag, typename... Payloads>
+		struct Array_elements<Object<Name_tag, Payloads...>>
+		{
+			/**
+			 * Checks every element of an array. Arrays longer than JSONTYPE_PARALLEL_CHECK_THRESHOLD are split in
+			 * chunks checked by different threads, stopping once an earlier element failed; the error is always the
+			 * one of the first bad element
+			 *
+			 * @throws Bad_structure if an element is not an object with the structure of the payloads
+			 */
+			template <typename Json_ref, typename Alloc>
+			static void check(Json_ref& array, Alloc&, Member_layout&, const char* array_name);
+
+			/**
+			 * Refreshes the fragments of the objects within the elements of the array member with the given tag,
+			 * marking the array as dirty if any element was modified
+			 */
+			template <typename Array_tag, typename Json_ref, typename Cache>
+			static void refresh_fragment(const Json_ref&, Cache&);
+		private:
+			struct Chunk
+			{
+				std::size_t failure;
+				std::string message;
+				bool canonical;
+			};
+
+			template <typename Json_ref, typename Alloc>
+			static void check_chunk(Json_ref& array,
+					Alloc&,
+					std::size_t begin,
+					std::size_t end,
+					std::atomic<std::size_t>& first_failure,
+					Chunk&);
+		};
+
+		/**
+		 * Hashes and compares json objects member by member in the order of their declaration, regardless of the
+		 * order of the members in the documents. Members not described by the payloads are ignored
+		 */
+		struct Member_comparer
+		{
+			template <typename... Payloads, typename Json_ref>
+			static std::size_t hash(const Json_ref& ref)
+			{
+				std::size_t seed = sizeof...(Payloads);
+				using Expander = int[];
+				(void)Expander{0, (hash_member(static_cast<Payloads*>(nullptr), ref,
+						Payload_index<Payloads, Payloads...>::value, seed), 0)...};
+				return seed;
+			}
+
+			template <typename... Payloads, typename Json_ref, typename Other_ref>
+			static bool equal(const Json_ref& ref, const Other_ref& other)
+			{
+				bool equal = true;
+				using Expander = int[];
+				(void)Expander{0, (equal = equal && equal_member(static_cast<Payloads*>(nullptr), ref, other,
+						Payload_index<Payloads, Payloads...>::value), 0)...};
+				return equal;
+			}
+		private:
+			template <typename Name_tag, typename... Payloads, typename Json_ref>
+			static void hash_member(Object<Name_tag, Payloads...>*, const Json_ref& ref, std::size_t position,
+					std::size_t& seed)
+			{
+				seed = hash_combine(seed, hash<Payloads...>(find_member<Name_tag>(ref, position)->value));
+			}
+
+			template <typename Payload, typename Json_ref>
+			static void hash_member(Payload*, const Json_ref& ref, std::size_t position, std::size_t& seed)
+			{
+				using Name_tag = typename Payload::Tag_type;
+				seed = hash_combine(seed, hash_value(find_member<Name_tag>(ref, position)->value));
+			}
+
+			template <typename Name_tag, typename Json_ref>
+			static void hash_member(Array<Name_tag>*, const Json_ref& ref, std::size_t position, std::size_t& seed)
+			{
+				seed = hash_combine(seed, hash_value(find_member<Name_tag>(ref, position)->value));
+			}
+
+			template <typename Name_tag, typename Element_tag, typename... Payloads, typename Json_ref>
+			static void hash_member(Array<Name_tag, Object<Element_tag, Payloads...>>*, const Json_ref& ref,
+					std::size_t position, std::size_t& seed)
+			{
+				std::size_t elements_seed = rapidjson::kArrayType;
+				for (const auto& element : find_member<Name_tag>(ref, position)->value.GetArray())
+				{
+					elements_seed = hash_combine(elements_seed, hash<Payloads...>(element));
+				}
+				seed = hash_combine(seed, elements_seed);
+			}
+
+			template <typename Name_tag, typename... Payloads, typename Json_ref, typename Other_ref>
+			static bool equal_member(Object<Name_tag, Payloads...>*, const Json_ref& ref, const Other_ref& other,
+					std::size_t position)
+			{
+				return equal<Payloads...>(find_member<Name_tag>(ref, position)->value,
+						find_member<Name_tag>(other, position)->value);
+			}
+
+			template <typename Payload, typename Json_ref, typename Other_ref>
+			static bool equal_member(Payload*, const Json_ref& ref, const Other_ref& other, std::size_t position)
+			{
+				using Name_tag = typename Payload::Tag_type;
+				return find_member<Name_tag>(ref, position)->value == find_member<Name_tag>(other, position)->value;
+			}
+
+			template <typename Name_tag, typename Json_ref, typename Other_ref>
+			static bool equal_member(Array<Name_tag>*, const Json_ref& ref, const Other_ref& other,
+					std::size_t position)
+			{
+				return find_member<Name_tag>(ref, position)->value == find_member<Name_tag>(other, position)->value;
+			}
+
+			template <typename Name_tag, typename Element_tag, typename... Payloads, typename Json_ref,
+					typename Other_ref>
+			static bool equal_member(Array<Name_tag, Object<Element_tag, Payloads...>>*, const Json_ref& ref,
+					const Other_ref& other, std::size_t position)
+			{
+				const auto& elements = find_member<Name_tag>(ref, position)->value;
+				const auto& other_elements = find_member<Name_tag>(other, position)->value;
+				if (elements.Size() != other_elements.Size())
+				{
+					return false;
+				}
+				for (rapidjson::SizeType i = 0; i < elements.Size(); ++i)
+				{
+					if (!equal<Payloads...>(elements[i], other_elements[i]))
+					{
+						return false;
+					}
+				}
+				return true;
+			}
+
+			// Consistent with rapidjson's equality: numbers are hashed by value and object members in any order
+			template <typename Json_ref>
+			static std::size_t hash_value(const Json_ref& value)
+			{
+				switch (value.GetType())
+				{
+				case rapidjson::kStringType:
+					return string_hash(value.GetString(), value.GetStringLength());
+				case rapidjson::kNumberType:
+				{
+					const double number = value.GetDouble() == 0.0 ? 0.0 : value.GetDouble();
+					std::uint64_t bits;
+					std::memcpy(&bits, &number, sizeof(bits));
+					return hash_combine(rapidjson::kNumberType, static_cast<std::size_t>(bits));
+				}
+				case rapidjson::kArrayType:
+				{
+					std::size_t seed = rapidjson::kArrayType;
+					for (const auto& element : value.GetArray())
+					{
+						seed = hash_combine(seed, hash_value(element));
+					}
+					return seed;
+				}
+				case rapidjson::kObjectType:
+				{
+					std::size_t seed = rapidjson::kObjectType;
+					for (const auto& member : value.GetObject())
+					{
+						seed += hash_combine(string_hash(member.name.GetString(), member.name.GetStringLength()),
+								hash_value(member.value));
+					}
+					return seed;
+				}
+				default:
+					return value.GetType();
+				}
+			}
+		};
+
 		template <typename Json_ref>
 		typename Character_traits<typename Json_ref::Ch>::String_type do_stringify(const Json_ref& ref)
 		{
-			using namespace rapidjson;
-			GenericStringBuffer<typename Json_ref::EncodingType> buffer;
-			Writer<decltype(buffer)> writer(buffer);
-			ref.Accept(writer);
+			rapidjson::GenericStringBuffer<typename Json_ref::EncodingType> buffer;
+			write_json(ref, buffer);
 			return buffer.GetString();
 		}
+
+		template <typename Json_ref, typename Output_stream>
+		void write_json(const Json_ref& ref, Output_stream& os)
+		{
+			rapidjson::Writer<Output_stream> writer(os);
+			ref.Accept(writer);
+			os.Flush();
+		}
+
+		template <typename Json_ref, typename Ch>
+		std::size_t write_json(const Json_ref& ref, Ch* data, std::size_t size)
+		{
+			Span_output_stream<Ch> os(data, size);
+			write_json(ref, os);
+			return os.length();
+		}
+	}
+
+	template <typename Document>
+	auto Interned_document<Document>::Parse(const Ch* json, std::size_t length) -> Interned_document&
+	{
+		using Encoding = typename Document::EncodingType;
+		auto& interner = string_interner();
+		auto generator = [&](auto& handler)
+		{
+			detail::Interning_handler<std::remove_reference_t<decltype(handler)>, String_interner> interning(handler,
+					interner);
+			rapidjson::MemoryStream bytes(reinterpret_cast<const char*>(json), length * sizeof(Ch));
+			rapidjson::EncodedInputStream<Encoding, rapidjson::MemoryStream> stream(bytes);
+			rapidjson::GenericReader<Encoding, Encoding> reader;
+			return !reader.Parse(stream, interning).IsError();
+		};
+		Document::Populate(generator);
+		return *this;
+	}
+
+	template <typename Document>
+	auto Counted_document<Document>::operator=(Counted_document&& other) -> Counted_document&
+	{
+		Document::operator=(std::move(other));
+		if (counters_ != other.counters_)
+		{
+			if (counters_)
+			{
+				--counters_->alive;
+			}
+			counters_ = other.counters_;
+			if (counters_)
+			{
+				++counters_->alive;
+			}
+		}
+		return *this;
+	}
+
+	template <typename Document>
+	void Counted_document<Document>::count(Root_counters& counters)
+	{
+		counters_ = &counters;
+		++counters.created;
+		++counters.alive;
+		counters.reserved += this->GetAllocator().Capacity();
 	}
 
 	template <typename Document, typename... Payloads>
 	Generic_root<Document, Payloads...>::Generic_root()
 	{
-		expand<decltype(document()),
-				decltype(document().GetAllocator()),
-				detail::Build_worker,
-				Payloads...>(document(), document().GetAllocator());
+		document().CopyFrom(prototype(), document().GetAllocator());
+		count_creation();
 	};
 
+	template <typename Document, typename... Payloads>
+	auto Generic_root<Document, Payloads...>::prototype() -> const Plain_document&
+	{
+		static const Plain_document prototype = []
+		{
+			Plain_document doc(rapidjson::kObjectType);
+			expand<Plain_document, typename Plain_document::AllocatorType, detail::Build_worker, Payloads...>(doc,
+					doc.GetAllocator());
+			return doc;
+		}();
+		return prototype;
+	}
+
 	template <typename Document, typename... Payloads>
 	Generic_root<Document, Payloads...>::Generic_root(const std::basic_string<typename Document::Ch>& json)
 	{
-		document().Parse(json);
-		structure_check();
+		measure(Root_phase::parse, [&] { document().Parse(json); });
+		measure(Root_phase::structure_check, [this] { structure_check(); });
+		count_creation();
+	}
+
+	template <typename Document, typename... Payloads>
+	Generic_root<Document, Payloads...>::Generic_root(const typename Document::Ch* json, std::size_t length)
+	{
+		measure(Root_phase::parse, [&] { document().Parse(json, length); });
+		measure(Root_phase::structure_check, [this] { structure_check(); });
+		count_creation();
+	}
+
+	template <typename Document, typename... Payloads>
+	Generic_root<Document, Payloads...>::Generic_root(Plain_document&& doc) : Base(std::move(doc))
+	{
+		measure(Root_phase::structure_check, [this] { structure_check(); });
+		count_creation();
+	}
+
+	template <typename Document, typename... Payloads>
+	auto Generic_root<Document, Payloads...>::from_file(const std::string& path) -> Generic_root
+	{
+		using Ch = typename Document::Ch;
+		const detail::Mapped_file file(path);
+		return Generic_root(reinterpret_cast<const Ch*>(file.data()), file.size() / sizeof(Ch));
+	}
+
+	template <typename Document, typename... Payloads>
+	auto Generic_root<Document, Payloads...>::clone() const -> Generic_root
+	{
+		Plain_document copy;
+		copy.CopyFrom(document(), copy.GetAllocator());
+		return Generic_root(detail::Unchecked{}, std::move(copy));
+	}
+
+	template <typename Document, typename... Payloads>
+	Memory_usage Generic_root<Document, Payloads...>::memory_usage() const
+	{
+		// Allocators expose their statistics only through non const documents
+		const auto& alloc = const_cast<Generic_root&>(*this).document().GetAllocator();
+		Plain_document copy;
+		copy.CopyFrom(document(), copy.GetAllocator());
+		const auto live = copy.GetAllocator().Size();
+		return Memory_usage{alloc.Capacity(), alloc.Size(), live, alloc.Size() - live};
+	}
+
+	template <typename Document, typename... Payloads>
+	void Generic_root<Document, Payloads...>::count_creation()
+	{
+		detail::count_creation(document(), counters());
 	}
 
 	template <typename Document, typename... Payloads>
-	Generic_root<Document, Payloads...>::Generic_root(rapidjson::Document&& doc) : Base(std::move(doc))
+	void Generic_root<Document, Payloads...>::compact()
 	{
-		structure_check();
+		Plain_document copy;
+		copy.CopyFrom(document(), copy.GetAllocator());
+		document().Swap(copy);
+		detail::clear_fragments(document());
 	}
 
 	template <typename Document, typename... Payloads>
@@ -525,10 +1460,23 @@ namespace jsontype
 		{
 			throw Bad_structure(std::string("Not a valid json"));
 		}
+		detail::Member_layout layout;
 		expand<decltype(document()),
 				decltype(document().GetAllocator()),
 				detail::Structure_check_worker,
-				Payloads...>(document(), document().GetAllocator());
+				Payloads...>(document(), document().GetAllocator(), detail::Structure_check_worker{layout});
+	}
+
+	template <typename Document, typename... Payloads>
+	bool Generic_root<Document, Payloads...>::canonical() const
+	{
+		detail::Member_layout layout;
+		detail::Const_alloc alloc;
+		expand<decltype(document()),
+				detail::Const_alloc,
+				detail::Structure_check_worker,
+				Payloads...>(document(), alloc, detail::Structure_check_worker{layout});
+		return layout.canonical;
 	}
 
 	template <typename Document, typename... Payloads>
@@ -539,21 +1487,94 @@ namespace jsontype
 		expand<Json_ref, Alloc, F, Ts...>(ref, alloc, f);
 	}
 
+	template <typename Document, typename... Payloads>
+	template <typename Ch>
+	std::size_t Generic_root<Document, Payloads...>::stringify_to(Ch* data, std::size_t size) const
+	{
+		Span_output_stream<Ch> os(data, size);
+		stringify_to(os);
+		return os.length();
+	}
+
+	template <typename Document, typename... Payloads>
+	template <typename Base_document>
+	auto Generic_root<Document, Payloads...>::refresh_fragments(const Tracked_document<Base_document>& doc)
+	{
+		auto& cache = doc.fragment_cache();
+		expand<decltype(doc), decltype(cache), detail::Fragment_worker, Payloads...>(doc, cache);
+		detail::refresh_fragment(doc, cache);
+		cache.clear_dirty();
+		return cache.find(doc);
+	}
+
+	template <typename Document, typename... Payloads>
+	template <typename Base_document>
+	auto Generic_root<Document, Payloads...>::stringify(const Tracked_document<Base_document>& doc)
+	{
+		const auto fragment = refresh_fragments(doc);
+		return fragment ? *fragment : detail::do_stringify(doc);
+	}
+
+	template <typename Document, typename... Payloads>
+	template <typename Base_document, typename Output_stream>
+	void Generic_root<Document, Payloads...>::write(const Tracked_document<Base_document>& doc, Output_stream& os)
+	{
+		const auto fragment = refresh_fragments(doc);
+		if (!fragment)
+		{
+			detail::write_json(doc, os);
+			return;
+		}
+		for (const auto c : *fragment)
+		{
+			os.Put(c);
+		}
+		os.Flush();
+	}
+
 	template <typename Document, typename... Payloads>
 	template <typename Name_tag>
-	auto Generic_root<Document, Payloads...>::find(Name_tag)
+	auto Generic_root<Document, Payloads...>::find(Name_tag tag)
+	{
+		return measure(Root_phase::find, [&] { return lookup(tag); });
+	}
+
+	template <typename Document, typename... Payloads>
+	template <typename Name_tag>
+	auto Generic_root<Document, Payloads...>::find(Name_tag tag) const
+	{
+		return measure(Root_phase::find, [&] { return lookup(tag); });
+	}
+
+	template <typename Document, typename... Payloads>
+	template <typename... K>
+	auto Generic_root<Document, Payloads...>::find(Key<K...>)
+	{
+		return measure(Root_phase::find, [this] { return lookup(typename Key<K...>::Args{}); });
+	}
+
+	template <typename Document, typename... Payloads>
+	template <typename... K>
+	auto Generic_root<Document, Payloads...>::find(Key<K...>) const
+	{
+		return measure(Root_phase::find, [this] { return lookup(typename Key<K...>::Args{}); });
+	}
+
+	template <typename Document, typename... Payloads>
+	template <typename Name_tag>
+	auto Generic_root<Document, Payloads...>::lookup(Name_tag)
 	{
 		static_assert(detail::is_tag<Name_tag>(), "Name tag template argument must be a tag class");
 		return detail::Finder{}.operator()<Generic_root<Payloads...>,
 				decltype(document()),
-				decltype(document().GetAllocator()),
+				decltype(proxy_alloc()),
 				Name_tag,
-				Payloads...>(document(), document().GetAllocator());
+				Payloads...>(document(), proxy_alloc());
 	}
 
 	template <typename Document, typename... Payloads>
 	template <typename Name_tag>
-	auto Generic_root<Document, Payloads...>::find(Name_tag) const
+	auto Generic_root<Document, Payloads...>::lookup(Name_tag) const
 	{
 		static_assert(detail::is_tag<Name_tag>(), "Name tag template argument must be a tag class");
 		return detail::Finder{}.operator()<Generic_root<Payloads...>,
@@ -564,17 +1585,19 @@ namespace jsontype
 	}
 
 	template <typename Document, typename... Payloads>
-	template <typename... K>
-	auto Generic_root<Document, Payloads...>::find(Key<K...>)
+	template <typename K, typename Next, typename... Ks>
+	auto Generic_root<Document, Payloads...>::lookup(detail::Pack<K, Next, Ks...>)
 	{
-		return detail::Key_unfolder()(*this, typename Key<K...>::Args{});
+		auto proxy = lookup(K{});
+		return detail::Key_unfolder()(proxy, detail::Pack<Next, Ks...>{});
 	}
 
 	template <typename Document, typename... Payloads>
-	template <typename... K>
-	auto Generic_root<Document, Payloads...>::find(Key<K...>) const
+	template <typename K, typename Next, typename... Ks>
+	auto Generic_root<Document, Payloads...>::lookup(detail::Pack<K, Next, Ks...>) const
 	{
-		return detail::Key_unfolder()(*this, typename Key<K...>::Args{});
+		auto proxy = lookup(K{});
+		return detail::Key_unfolder()(proxy, detail::Pack<Next, Ks...>{});
 	}
 
 	template <typename Document, typename... Payloads>
@@ -600,13 +1623,14 @@ namespace jsontype
 
 	template <typename Name_tag, typename T>
 	template <typename Json_ref, typename Alloc>
-	void Basic_value_field<Name_tag, T>::structure_check(Json_ref& ref, Alloc&)
+	void Basic_value_field<Name_tag, T>::structure_check(Json_ref& ref, Alloc&, detail::Member_layout& layout)
 	{
-		if (!ref.HasMember(Name_tag::name()))
+		const auto member = detail::find_member<Name_tag>(ref, layout);
+		if (member == ref.MemberEnd())
 		{
 			throw Bad_structure(std::string("Missing value member: ") + Name_tag::name());
 		}
-		if (!detail::Value_traits<T>::check(ref[Name_tag::name()]))
+		if (!detail::Value_traits<T>::check(member->value))
 		{
 			throw Bad_structure("Value of " + std::string(Name_tag::name()) + " is of the wrong type");
 		}
@@ -616,21 +1640,22 @@ namespace jsontype
 	template <typename Json_ref, typename Alloc>
 	void Value_field<Name_tag, T>::build(Json_ref& ref, Alloc& alloc, Param_type value)
 	{
-		ref.AddMember(rapidjson::StringRef(Name_tag::name()), value, alloc);
+		ref.AddMember(rapidjson::StringRef(Name_tag::name(), Name_tag::length()), value, alloc);
 	}
 
 	template <typename Name_tag, typename T>
 	template <typename Json_ref, typename Alloc>
 	void Value_field<Name_tag, T>::set(Json_ref& ref, Alloc& alloc, Param_type value)
 	{
-		detail::Value_traits<T>::set(ref, alloc, value);
+		detail::set_value<T>(ref, alloc, value);
+		detail::mark_dirty(alloc, ref);
 	}
 
 	template <typename Name_tag>
 	template <typename Json_ref, typename Alloc>
 	void Value_field<Name_tag, const char*>::build(Json_ref& ref, Alloc& alloc, const char* value)
 	{
-		ref.AddMember(rapidjson::StringRef(Name_tag::name()),
+		ref.AddMember(rapidjson::StringRef(Name_tag::name(), Name_tag::length()),
 				rapidjson::StringRef(value),
 				alloc);
 	}
@@ -639,7 +1664,8 @@ namespace jsontype
 	template <typename Json_ref, typename Alloc>
 	void Value_field<Name_tag, const char*>::set(Json_ref& ref, Alloc& alloc, const char* value)
 	{
-		detail::Value_traits<const char*>::set(ref, alloc, value);
+		detail::set_value<const char*>(ref, alloc, value);
+		detail::mark_dirty(alloc, ref);
 	}
 
 	template <typename Name_tag, typename... Payloads>
@@ -647,35 +1673,64 @@ namespace jsontype
 	void Object<Name_tag, Payloads...>::build(Json_ref& ref, Alloc& alloc)
 	{
 		rapidjson::Value value(rapidjson::kObjectType);
-		ref.AddMember(rapidjson::StringRef(Name_tag::name()), value, alloc);
+		ref.AddMember(rapidjson::StringRef(Name_tag::name(), Name_tag::length()), value, alloc);
 		expand<Json_ref, Alloc, detail::Build_worker, Payloads...>(ref, alloc);
 	}
 
 	template <typename Name_tag, typename... Payloads>
 	template <typename Json_ref, typename Alloc>
-	void Object<Name_tag, Payloads...>::structure_check(Json_ref& ref, Alloc& alloc)
+	void Object<Name_tag, Payloads...>::structure_check(Json_ref& ref, Alloc& alloc, detail::Member_layout& layout)
 	{
-		if (!ref.HasMember(Name_tag::name()))
+		const auto member = detail::find_member<Name_tag>(ref, layout);
+		if (member == ref.MemberEnd())
 		{
 			throw Bad_structure(std::string("Missing object member: ") + Name_tag::name());
 		}
-		if (!ref[Name_tag::name()].IsObject())
+		if (!member->value.IsObject())
 		{
 			throw Bad_structure(std::string(Name_tag::name()) + " is not an object");
 		}
-		expand<Json_ref, Alloc, detail::Structure_check_worker, Payloads...>(ref, alloc);
+		detail::Member_layout member_layout;
+		check_members(member->value, alloc, member_layout);
+		layout.canonical = layout.canonical && member_layout.canonical;
 	}
 
 	template <typename Name_tag, typename... Payloads>
-	template <typename Json_ref, typename Alloc, typename F, typename T, typename... Ts>
-	auto Object<Name_tag, Payloads...>::expand(Json_ref& ref, Alloc& alloc, const F& f)
-			-> typename std::enable_if<!std::is_same<Name_tag, T>::value>::type
+	template <typename Json_ref, typename Alloc>
+	void Object<Name_tag, Payloads...>::check_members(Json_ref& ref, Alloc& alloc, detail::Member_layout& layout)
+	{
+		expand_members<Json_ref, Alloc, detail::Structure_check_worker, Payloads...>(ref,
+				alloc,
+				detail::Structure_check_worker{layout});
+	}
+
+	template <typename Name_tag, typename... Payloads>
+	template <typename Json_ref, typename Cache>
+	void Object<Name_tag, Payloads...>::refresh_fragment(const Json_ref& ref, Cache& cache)
+	{
+		expand<const Json_ref, Cache, detail::Fragment_worker, Payloads...>(ref, cache);
+		const auto& value = detail::find_member<Name_tag>(ref)->value;
+		if (detail::refresh_fragment(value, cache))
+		{
+			cache.mark_dirty(&value);
+		}
+	}
+
+	template <typename Name_tag, typename... Payloads>
+	template <typename Json_ref, typename Alloc, typename F, typename... Ts>
+	void Object<Name_tag, Payloads...>::expand(Json_ref& ref, Alloc& alloc, const F& f)
 	{
-		auto json_handle = ref.FindMember(Name_tag::name());
+		auto json_handle = detail::find_member<Name_tag>(ref);
 		assert(json_handle != ref.MemberEnd());
-		f.template operator()<Object<Name_tag, Payloads...>, decltype(json_handle->value), Alloc, T>(json_handle->value,
-				alloc);
-		expand<Json_ref, Alloc, F, Ts...>(ref, alloc, f);
+		expand_members<decltype((json_handle->value)), Alloc, F, Ts...>(json_handle->value, alloc, f);
+	}
+
+	template <typename Name_tag, typename... Payloads>
+	template <typename Json_ref, typename Alloc, typename F, typename T, typename... Ts>
+	void Object<Name_tag, Payloads...>::expand_members(Json_ref& ref, Alloc& alloc, const F& f)
+	{
+		f.template operator()<Object<Name_tag, Payloads...>, Json_ref, Alloc, T>(ref, alloc);
+		expand_members<Json_ref, Alloc, F, Ts...>(ref, alloc, f);
 	}
 
 	template <typename Name_tag, typename... Payloads>
@@ -701,27 +1756,241 @@ namespace jsontype
 		return *this;
 	}
 
-	template <typename Name_tag>
+	template <typename Name_tag, typename... Element>
 	template <typename Json_ref, typename Alloc>
-	void Array<Name_tag>::build(Json_ref& ref, Alloc& alloc)
+	void Array<Name_tag, Element...>::build(Json_ref& ref, Alloc& alloc)
 	{
 		rapidjson::Value value(rapidjson::kArrayType);
-		ref.AddMember(rapidjson::StringRef(Name_tag::name()), value, alloc);
+		ref.AddMember(rapidjson::StringRef(Name_tag::name(), Name_tag::length()), value, alloc);
 	}
 
-	template <typename Name_tag>
+	template <typename Name_tag, typename... Element>
 	template <typename Json_ref, typename Alloc>
-	void Array<Name_tag>::structure_check(Json_ref& ref, Alloc&)
+	void Array<Name_tag, Element...>::structure_check(Json_ref& ref, Alloc& alloc, detail::Member_layout& layout)
 	{
-		if (!ref.HasMember(Name_tag::name()))
+		const auto member = detail::find_member<Name_tag>(ref, layout);
+		if (member == ref.MemberEnd())
 		{
 			throw Bad_structure(std::string("Missing array member: ") + Name_tag::name());
 		}
-		if (!ref[Name_tag::name()].IsArray())
+		if (!member->value.IsArray())
 		{
 			throw Bad_structure(std::string(Name_tag::name()) + " is not an array");
 		}
+		detail::Array_elements<Element...>::check(member->value, alloc, layout, Name_tag::name());
+	}
+
+	template <typename Name_tag, typename... Element>
+	template <typename Json_ref, typename Cache>
+	void Array<Name_tag, Element...>::refresh_fragment(const Json_ref& ref, Cache& cache)
+	{
+		detail::Array_elements<Element...>::template refresh_fragment<Name_tag>(ref, cache);
+	}
+
+	template <typename Payload, typename Json_ref, typename Alloc>
+	auto Array_proxy<Payload, Json_ref, Alloc>::operator[](std::size_t index)
+	{
+		static_assert(detail::Element_count<Payload>::value == 1, "Only arrays with a declared element can be indexed");
+		using Element = typename detail::Element_of<Payload>::type;
+		assert(index < size());
+		return Object_proxy<Element, Json_ref, Alloc>(this->ref()[static_cast<rapidjson::SizeType>(index)],
+				this->alloc());
 	}
+
+	template <typename Payload, typename Json_ref, typename Alloc>
+	auto Array_proxy<Payload, Json_ref, Alloc>::operator[](std::size_t index) const
+	{
+		static_assert(detail::Element_count<Payload>::value == 1, "Only arrays with a declared element can be indexed");
+		using Element = typename detail::Element_of<Payload>::type;
+		assert(index < size());
+		return Object_proxy<Element, Json_ref>(this->ref()[static_cast<rapidjson::SizeType>(index)]);
+	}
+
+	namespace detail
+	{
+		inline Check_executor& check_executor()
+		{
+			static Check_executor executor;
+			return executor;
+		}
+
+		inline std::size_t core_count()
+		{
+			static const std::size_t count = std::thread::hardware_concurrency();
+			return count;
+		}
+
+		// Set while the calling thread checks a chunk of an array, so the arrays within its elements aren't split
+		inline bool& checking_chunk()
+		{
+			static thread_local bool checking = false;
+			return checking;
+		}
+
+		template <typename Name_tag, typename... Payloads>
+		template <typename Json_ref, typename Alloc>
+		void Array_elements<Object<Name_tag, Payloads...>>::check(Json_ref& array,
+				Alloc& alloc,
+				Member_layout& layout,
+				const char* array_name)
+		{
+			const std::size_t size = array.Size();
+			const std::size_t threshold = JSONTYPE_PARALLEL_CHECK_THRESHOLD;
+			const std::size_t chunk_count = (size + threshold - 1) / threshold;
+			const auto& executor = check_executor();
+			const std::size_t count = chunk_count <= 1 || checking_chunk() ? 1
+					: executor ? chunk_count : std::max<std::size_t>(1, std::min(core_count(), chunk_count));
+			std::vector<Chunk> chunks(count, Chunk{size, std::string(), true});
+			std::atomic<std::size_t> first_failure{size};
+			if (count == 1)
+			{
+				check_chunk(array, alloc, 0, size, first_failure, chunks[0]);
+			}
+			else
+			{
+				const std::function<void(std::size_t)> chunk = [&](std::size_t i)
+				{
+					checking_chunk() = true;
+					try
+					{
+						check_chunk(array, alloc, size * i / count, size * (i + 1) / count, first_failure, chunks[i]);
+					}
+					catch (...)
+					{
+						checking_chunk() = false;
+						throw;
+					}
+					checking_chunk() = false;
+				};
+				if (executor)
+				{
+					executor(count, chunk);
+				}
+				else
+				{
+					std::vector<std::future<void>> workers;
+					workers.reserve(count - 1);
+					for (std::size_t i = 1; i < count; ++i)
+					{
+						workers.push_back(std::async(std::launch::async, chunk, i));
+					}
+					chunk(0);
+					for (auto& worker : workers)
+					{
+						worker.get();
+					}
+				}
+			}
+			// Chunks before the first failing one were checked up to their end
+			for (const auto& chunk : chunks)
+			{
+				if (chunk.failure != size)
+				{
+					throw Bad_structure("Element " + std::to_string(chunk.failure) + " of " + array_name + ": "
+							+ chunk.message);
+				}
+				layout.canonical = layout.canonical && chunk.canonical;
+			}
+		}
+
+		template <typename Name_tag, typename... Payloads>
+		template <typename Json_ref, typename Alloc>
+		void Array_elements<Object<Name_tag, Payloads...>>::check_chunk(Json_ref& array,
+				Alloc& alloc,
+				std::size_t begin,
+				std::size_t end,
+				std::atomic<std::size_t>& first_failure,
+				Chunk& chunk)
+		{
+			for (auto i = begin; i != end && i < first_failure.load(std::memory_order_relaxed); ++i)
+			{
+				auto& element = array[static_cast<rapidjson::SizeType>(i)];
+				try
+				{
+					if (!element.IsObject())
+					{
+						throw Bad_structure(std::string(Name_tag::name()) + " is not an object");
+					}
+					Member_layout element_layout;
+					Object<Name_tag, Payloads...>::check_members(element, alloc, element_layout);
+					chunk.canonical = chunk.canonical && element_layout.canonical;
+				}
+				catch (const Bad_structure& e)
+				{
+					chunk.failure = i;
+					chunk.message = e.what();
+					auto first = first_failure.load(std::memory_order_relaxed);
+					while (i < first && !first_failure.compare_exchange_weak(first, i, std::memory_order_relaxed))
+					{}
+					return;
+				}
+			}
+		}
+
+		template <typename Name_tag, typename... Payloads>
+		template <typename Array_tag, typename Json_ref, typename Cache>
+		void Array_elements<Object<Name_tag, Payloads...>>::refresh_fragment(const Json_ref& ref, Cache& cache)
+		{
+			const auto& array = find_member<Array_tag>(ref)->value;
+			bool dirty = false;
+			for (const auto& element : array.GetArray())
+			{
+				using Element_ref = std::remove_reference_t<decltype(element)>;
+				Object<Name_tag, Payloads...>::template expand_members<Element_ref, Cache, Fragment_worker, Payloads...>(
+						element,
+						cache,
+						Fragment_worker{});
+				dirty = dirty || cache.dirty_within(element);
+			}
+			if (dirty)
+			{
+				cache.mark_dirty(&array);
+			}
+		}
+	}
+
+	template <typename Document, typename... Payloads>
+	std::size_t hash(const Generic_root<Document, Payloads...>& root)
+	{
+		return detail::Member_comparer::hash<Payloads...>(root.ref());
+	}
+
+	template <typename Name_tag, typename... Payloads, typename Json_ref, typename Alloc>
+	std::size_t hash(const Object_proxy<Object<Name_tag, Payloads...>, Json_ref, Alloc>& proxy)
+	{
+		return detail::Member_comparer::hash<Payloads...>(proxy.ref());
+	}
+
+	template <typename Document, typename Other_document, typename... Payloads>
+	bool operator==(const Generic_root<Document, Payloads...>& lhs,
+			const Generic_root<Other_document, Payloads...>& rhs)
+	{
+		return detail::Member_comparer::equal<Payloads...>(lhs.ref(), rhs.ref());
+	}
+
+	template <typename Name_tag, typename... Payloads, typename Json_ref, typename Alloc, typename Other_ref, typename Other_alloc>
+	bool operator==(const Object_proxy<Object<Name_tag, Payloads...>, Json_ref, Alloc>& lhs,
+			const Object_proxy<Object<Name_tag, Payloads...>, Other_ref, Other_alloc>& rhs)
+	{
+		return detail::Member_comparer::equal<Payloads...>(lhs.ref(), rhs.ref());
+	}
+
+	void set_check_executor(Check_executor executor)
+	{
+		detail::check_executor() = std::move(executor);
+	}
+}
+
+namespace std
+{
+	template <typename Document, typename... Payloads>
+	struct hash<jsontype::Generic_root<Document, Payloads...>>
+	{
+		std::size_t operator()(const jsontype::Generic_root<Document, Payloads...>& root) const
+		{
+			return jsontype::hash(root);
+		}
+	};
 }
 
 #endif
@@ -0,0 +1,178 @@
+// Copyright (C) 2017 Andrea Spurio. All rights reserved.
+//
+// Licensed under the MIT License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// http://opensource.org/licenses/MIT
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef JSONTYPE_ROOT_BATCH_HPP_
+#define JSONTYPE_ROOT_BATCH_HPP_
+
+#include <string>
+#include <cstddef>
+#include <stdexcept>
+#include <rapidjson/document.h>
+#include "Root.hpp"
+
+namespace jsontype
+{
+	namespace detail
+	{
+		/**
+		 * Checks that the given json object has all the members described by the payloads
+		 *
+		 * @throws Bad_structure if the object's structure is not compatible with the payloads
+		 */
+		template <typename Owner, typename... Payloads, typename Json_ref, typename Alloc>
+		void check_members(Json_ref& ref, Alloc& alloc)
+		{
+			if (!ref.IsObject())
+			{
+				throw Bad_structure(std::string("Not a json object"));
+			}
+			Member_layout layout;
+			const Structure_check_worker worker{layout};
+			using Expander = int[];
+			(void)Expander{0, (worker.template operator()<Owner, Json_ref, Alloc, Payloads>(ref, alloc), 0)...};
+		}
+	}
+
+	/**
+	 * Sequence of json objects sharing the same structure, stored as a single json array.
+	 * All the records live in one allocator and each of them is accessed through a view with the same interface
+	 * as a root.
+	 */
+	template <typename... Payloads>
+	class Root_batch
+	{
+		using Record = Object<detail::No_name_tag, Payloads...>;
+		using Allocator = rapidjson::Document::AllocatorType;
+	public:
+		using Ch = rapidjson::Document::Ch;
+
+		/**
+		 * Creates an empty batch
+		 */
+		Root_batch() { document_.SetArray(); }
+		/**
+		 * Creates a batch out of a json array of records
+		 *
+		 * @throws Bad_structure if the json is not an array or one of its elements is not compatible with the records
+		 */
+		explicit Root_batch(const std::basic_string<Ch>& json) : Root_batch(json.data(), json.size()) {}
+		Root_batch(const Ch* json, std::size_t length);
+		Root_batch(Root_batch&&) = default;
+		Root_batch& operator=(Root_batch&&) = default;
+
+		/**
+		 * Parses a json document and appends it to the batch. Views of the records obtained before are invalidated
+		 *
+		 * @throws Bad_structure if the document's structure is not compatible with the records
+		 */
+		void push_back(const std::basic_string<Ch>& json) { push_back(json.data(), json.size()); }
+		void push_back(const Ch* json, std::size_t length);
+
+		std::size_t size() const { return document_.Size(); }
+		bool empty() const { return document_.Empty(); }
+
+		auto operator[](std::size_t index) { return Record_view(document_[index], document_.GetAllocator()); }
+		auto operator[](std::size_t index) const { return Const_record_view(document_[index]); }
+
+		/**
+		 * @throws Out_of_range if index is not smaller than the size of the batch
+		 */
+		auto at(std::size_t index);
+		auto at(std::size_t index) const;
+
+		/**
+		 * @returns A reference to the underlying json array
+		 */
+		const auto& document() const { return document_; }
+		/**
+		 * @returns A json string representation of the whole batch
+		 */
+		auto stringify() const { return detail::do_stringify(document_); }
+	private:
+		using Record_view = Object_proxy<Record, rapidjson::Value, Allocator>;
+		using Const_record_view = Object_proxy<Record, rapidjson::Value>;
+
+		void check_range(std::size_t index) const;
+		static void check_record(rapidjson::Value&, Allocator&, std::size_t index);
+
+		rapidjson::Document document_;
+	};
+
+	//
+	// Definitions
+	//
+
+	template <typename... Payloads>
+	Root_batch<Payloads...>::Root_batch(const Ch* json, std::size_t length)
+	{
+		document_.Parse(json, length);
+		if (!document_.IsArray())
+		{
+			throw Bad_structure(std::string("Not a valid json array"));
+		}
+		for (std::size_t i = 0; i < size(); ++i)
+		{
+			check_record(document_[i], document_.GetAllocator(), i);
+		}
+	}
+
+	template <typename... Payloads>
+	void Root_batch<Payloads...>::push_back(const Ch* json, std::size_t length)
+	{
+		rapidjson::Document record(&document_.GetAllocator());
+		record.Parse(json, length);
+		if (record.HasParseError())
+		{
+			throw Bad_structure(std::string("Not a valid json"));
+		}
+		check_record(record, document_.GetAllocator(), size());
+		document_.PushBack(static_cast<rapidjson::Value&>(record), document_.GetAllocator());
+	}
+
+	template <typename... Payloads>
+	auto Root_batch<Payloads...>::at(std::size_t index)
+	{
+		check_range(index);
+		return (*this)[index];
+	}
+
+	template <typename... Payloads>
+	auto Root_batch<Payloads...>::at(std::size_t index) const
+	{
+		check_range(index);
+		return (*this)[index];
+	}
+
+	template <typename... Payloads>
+	void Root_batch<Payloads...>::check_range(std::size_t index) const
+	{
+		if (index >= size())
+		{
+			throw std::out_of_range("Record " + std::to_string(index) + " is out of the batch's range");
+		}
+	}
+
+	template <typename... Payloads>
+	void Root_batch<Payloads...>::check_record(rapidjson::Value& record, Allocator& alloc, std::size_t index)
+	{
+		try
+		{
+			detail::check_members<Record, Payloads...>(record, alloc);
+		}
+		catch (const Bad_structure& e)
+		{
+			throw Bad_structure("Record " + std::to_string(index) + ": " + e.what());
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,148 @@
+// Copyright (C) 2017 Andrea Spurio. All rights reserved.
+//
+// Licensed under the MIT License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// http://opensource.org/licenses/MIT
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef JSONTYPE_SNAPSHOT_HPP_
+#define JSONTYPE_SNAPSHOT_HPP_
+
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include "Root.hpp"
+
+namespace jsontype
+{
+	namespace detail
+	{
+		template <typename Root>
+		struct Shareable : std::true_type {};
+
+		template <typename Document, typename... Payloads>
+		struct Shareable<Generic_root<Tracked_document<Document>, Payloads...>> : std::false_type {};
+	}
+
+	/**
+	 * Immutable root shared among any number of threads.
+	 * Copies are cheap and refer to the same root, which is destroyed together with the last of them.
+	 */
+	template <typename Root>
+	class Snapshot
+	{
+		static_assert(detail::Shareable<Root>::value,
+				"Tracked roots update their serialization cache on const access and can't be shared");
+
+		template <typename Document, typename... Payloads>
+		friend Snapshot<Generic_root<Document, Payloads...>> freeze(Generic_root<Document, Payloads...>&&);
+	public:
+		const Root& operator*() const { return *root_; }
+		const Root* operator->() const { return root_.get(); }
+
+		template <typename T>
+		auto find(T tag) const { return root_->find(tag); }
+
+		template <typename T>
+		auto operator[](T tag) const { return root_->find(tag); }
+
+		/**
+		 * @returns A json string representation of the root
+		 */
+		auto stringify() const { return root_->stringify(); }
+	private:
+		explicit Snapshot(std::shared_ptr<const Root>&& root) : root_(std::move(root)) {}
+
+		std::shared_ptr<const Root> root_;
+	};
+
+	/**
+	 * Turns a root into an immutable snapshot
+	 */
+	template <typename Document, typename... Payloads>
+	Snapshot<Generic_root<Document, Payloads...>> freeze(Generic_root<Document, Payloads...>&& root)
+	{
+		using Root = Generic_root<Document, Payloads...>;
+		return Snapshot<Root>(std::make_shared<const Root>(std::move(root)));
+	}
+
+	/**
+	 * Holds the current snapshot of a root, which can be replaced while other threads are reading it.
+	 * Readers never take a lock: they announce themselves in the counter of the current epoch before reading the
+	 * snapshot. A writer publishes a new snapshot, moves the following readers to the other epoch and waits for the
+	 * readers of the previous one to be done before releasing the old snapshot. Writers are serialized among
+	 * themselves.
+	 */
+	template <typename Root>
+	class Snapshot_holder
+	{
+	public:
+		explicit Snapshot_holder(Snapshot<Root> snapshot) : current_(new Snapshot<Root>(std::move(snapshot))) {}
+		Snapshot_holder(const Snapshot_holder&) = delete;
+		Snapshot_holder& operator=(const Snapshot_holder&) = delete;
+		~Snapshot_holder() { delete current_.load(); }
+
+		/**
+		 * @returns The last published snapshot
+		 */
+		Snapshot<Root> load() const;
+
+		/**
+		 * Publishes a new snapshot. Readers holding the old one can keep using it
+		 */
+		void store(Snapshot<Root>);
+	private:
+		std::atomic<const Snapshot<Root>*> current_;
+		mutable std::atomic<unsigned> epoch_{0};
+		mutable std::atomic<unsigned> readers_[2] = {{0}, {0}};
+		std::mutex writer_mutex_;
+	};
+
+	//
+	// Definitions
+	//
+
+	template <typename Root>
+	Snapshot<Root> Snapshot_holder<Root>::load() const
+	{
+		unsigned epoch = epoch_.load();
+		for (;;)
+		{
+			readers_[epoch & 1].fetch_add(1);
+			const auto current_epoch = epoch_.load();
+			if (current_epoch == epoch)
+			{
+				break;
+			}
+			readers_[epoch & 1].fetch_sub(1);
+			epoch = current_epoch;
+		}
+		Snapshot<Root> snapshot(*current_.load());
+		readers_[epoch & 1].fetch_sub(1);
+		return snapshot;
+	}
+
+	template <typename Root>
+	void Snapshot_holder<Root>::store(Snapshot<Root> snapshot)
+	{
+		const auto next = new Snapshot<Root>(std::move(snapshot));
+		std::lock_guard<std::mutex> lock(writer_mutex_);
+		const auto previous = current_.exchange(next);
+		const auto epoch = epoch_.fetch_add(1);
+		while (readers_[epoch & 1].load() != 0)
+		{
+			std::this_thread::yield();
+		}
+		delete previous;
+	}
+}
+
+#endif
@@ -0,0 +1,374 @@
+// Copyright (C) 2017 Andrea Spurio. All rights reserved.
+//
+// Licensed under the MIT License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// http://opensource.org/licenses/MIT
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef JSONTYPE_STRING_POOL_HPP_
+#define JSONTYPE_STRING_POOL_HPP_
+
+#include <string>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <cstddef>
+#include <cstdint>
+#include <rapidjson/document.h>
+#include "detail/Utility.hpp"
+
+namespace jsontype
+{
+	namespace detail
+	{
+		/**
+		 * Characters of a string kept elsewhere, compared and hashed by content
+		 */
+		template <typename Ch>
+		struct String_key
+		{
+			const Ch* data;
+			std::size_t length;
+
+			bool operator==(const String_key& other) const
+			{
+				return length == other.length && std::char_traits<Ch>::compare(data, other.data, length) == 0;
+			}
+		};
+
+		template <typename Ch>
+		struct String_key_hash
+		{
+			std::size_t operator()(const String_key<Ch>& key) const { return string_hash(key.data, key.length); }
+		};
+	}
+
+	/**
+	 * Thread safe set of unique strings shared by many documents.
+	 * Every document referring to a string of the pool owns a reference to it; strings which are no longer
+	 * referred by any document are released by release_unused(). The strings are spread over shards locked
+	 * separately, so threads interning different strings rarely wait for each other.
+	 */
+	template <typename Ch>
+	class String_pool
+	{
+	public:
+		using String_type = std::basic_string<Ch>;
+		using Handle = std::shared_ptr<const String_type>;
+
+		/**
+		 * @returns The pool used by the interned documents of the process
+		 */
+		static const std::shared_ptr<String_pool>& shared();
+
+		/**
+		 * @returns A reference to the pooled string equal to the given one, which is added if missing
+		 */
+		Handle intern(const Ch* str, std::size_t length);
+
+		/**
+		 * @returns The number of strings in the pool
+		 */
+		std::size_t size() const;
+
+		/**
+		 * Removes the strings not referred by any document
+		 *
+		 * @returns The number of strings removed
+		 */
+		std::size_t release_unused();
+	private:
+		using Key = detail::String_key<Ch>;
+
+		struct Shard
+		{
+			mutable std::mutex mutex;
+			std::unordered_map<Key, Handle, detail::String_key_hash<Ch>> strings;
+		};
+
+		static constexpr std::size_t shard_count = 16;
+
+		// The low bits of the hash pick the bucket within the shard, so the shard comes from the high ones
+		static std::size_t shard_of(std::size_t hash) { return (hash >> (sizeof(std::size_t) * 8 - 4)) % shard_count; }
+
+		Shard shards_[shard_count];
+	};
+
+	namespace detail
+	{
+		/**
+		 * References of a document to the strings of a pool. String values are looked up in the pool when they are
+		 * set and the document's values point to them rather than to a copy in its allocator.
+		 * Member names and strings short enough to be kept inside a rapidjson value are not interned, as they take
+		 * no memory of their own. The document holds one reference for each distinct pooled string and counts the
+		 * values using it, so repeated strings are found without going to the pool.
+		 */
+		template <typename Allocator, typename Ch>
+		class String_interner
+		{
+		public:
+			using String_type = std::basic_string<Ch>;
+
+			explicit String_interner(std::shared_ptr<String_pool<Ch>> pool) : pool_(std::move(pool)) {}
+
+			void bind(Allocator& alloc) { alloc_ = &alloc; }
+			Allocator& allocator() const { return *alloc_; }
+			const auto& pool() const { return pool_; }
+
+			/**
+			 * @returns The number of distinct pooled strings referred by the document
+			 */
+			std::size_t size() const { return strings_.size(); }
+
+			/**
+			 * @returns Whether a string fits inside a rapidjson value, which is where rapidjson copies short strings
+			 */
+			static constexpr bool inline_string(std::size_t length) { return length <= inline_length; }
+
+			/**
+			 * @returns A pooled copy of the given string, referenced until the document drops all its uses
+			 */
+			const String_type& intern(const Ch* str, std::size_t length);
+
+			/**
+			 * Sets a json value to a string, pooled unless it's short, dropping the use of the string it had before
+			 */
+			template <typename Json_ref>
+			void set(Json_ref& ref, const String_type& value) { set(ref, value.data(), value.size()); }
+
+			template <typename Json_ref>
+			void set(Json_ref& ref, const Ch* value, std::size_t length);
+
+			/**
+			 * Makes every long string value within a json value refer to the pool
+			 */
+			template <typename Json_ref>
+			void intern_all(Json_ref& ref);
+		private:
+			// Size of the payload of a rapidjson value, less the terminator, as computed by rapidjson's ShortString
+#if RAPIDJSON_48BITPOINTER_OPTIMIZATION
+			static constexpr std::size_t inline_length = (sizeof(rapidjson::SizeType) * 2 + 6) / sizeof(Ch) - 1;
+#elif RAPIDJSON_64BIT
+			static constexpr std::size_t inline_length =
+					(sizeof(rapidjson::SizeType) * 2 + sizeof(void*) + 6) / sizeof(Ch) - 1;
+#else
+			static constexpr std::size_t inline_length =
+					(sizeof(rapidjson::SizeType) * 2 + sizeof(void*) + 2) / sizeof(Ch) - 1;
+#endif
+
+			struct Use
+			{
+				typename String_pool<Ch>::Handle handle;
+				std::size_t count;
+			};
+
+			void release(const Ch* str, std::size_t length);
+
+			std::shared_ptr<String_pool<Ch>> pool_;
+			Allocator* alloc_ = nullptr;
+			// Keyed by the pooled characters, which the values point to
+			std::unordered_map<String_key<Ch>, Use, String_key_hash<Ch>> strings_;
+		};
+
+		template <typename Allocator, typename Ch>
+		Allocator& base_alloc(String_interner<Allocator, Ch>& interner) { return interner.allocator(); }
+
+		template <typename T, typename Json_ref, typename Allocator, typename Ch>
+		void set_value(Json_ref& ref, String_interner<Allocator, Ch>& interner, const std::basic_string<Ch>& value)
+		{
+			interner.set(ref, value);
+		}
+
+		template <typename T, typename Json_ref, typename Allocator, typename Ch>
+		void set_value(Json_ref& ref, String_interner<Allocator, Ch>& interner, const Ch* value)
+		{
+			interner.set(ref, value, std::char_traits<Ch>::length(value));
+		}
+
+		/**
+		 * Reader handler building a document whose strings refer to a pool
+		 */
+		template <typename Document, typename Interner>
+		class Interning_handler
+		{
+		public:
+			using Ch = typename Document::Ch;
+
+			Interning_handler(Document& doc, Interner& interner) : doc_(doc), interner_(interner) {}
+
+			bool Null() { return doc_.Null(); }
+			bool Bool(bool b) { return doc_.Bool(b); }
+			bool Int(int i) { return doc_.Int(i); }
+			bool Uint(unsigned i) { return doc_.Uint(i); }
+			bool Int64(std::int64_t i) { return doc_.Int64(i); }
+			bool Uint64(std::uint64_t i) { return doc_.Uint64(i); }
+			bool Double(double d) { return doc_.Double(d); }
+			bool RawNumber(const Ch* str, rapidjson::SizeType length, bool copy) { return String(str, length, copy); }
+			bool String(const Ch* str, rapidjson::SizeType length, bool copy)
+			{
+				if (Interner::inline_string(length))
+				{
+					return doc_.String(str, length, copy);
+				}
+				return doc_.String(interner_.intern(str, length).data(), length, false);
+			}
+			bool StartObject() { return doc_.StartObject(); }
+			bool Key(const Ch* str, rapidjson::SizeType length, bool copy) { return doc_.Key(str, length, copy); }
+			bool EndObject(rapidjson::SizeType count) { return doc_.EndObject(count); }
+			bool StartArray() { return doc_.StartArray(); }
+			bool EndArray(rapidjson::SizeType count) { return doc_.EndArray(count); }
+		private:
+			Document& doc_;
+			Interner& interner_;
+		};
+	}
+
+	//
+	// Definitions
+	//
+
+	template <typename Ch>
+	auto String_pool<Ch>::shared() -> const std::shared_ptr<String_pool>&
+	{
+		static const auto pool = std::make_shared<String_pool>();
+		return pool;
+	}
+
+	template <typename Ch>
+	auto String_pool<Ch>::intern(const Ch* str, std::size_t length) -> Handle
+	{
+		const Key key{str, length};
+		const auto hash = detail::String_key_hash<Ch>()(key);
+		auto& shard = shards_[shard_of(hash)];
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		const auto it = shard.strings.find(key);
+		if (it != shard.strings.cend())
+		{
+			return it->second;
+		}
+		auto handle = std::make_shared<const String_type>(str, length);
+		shard.strings.emplace(Key{handle->data(), length}, handle);
+		return handle;
+	}
+
+	template <typename Ch>
+	std::size_t String_pool<Ch>::size() const
+	{
+		std::size_t size = 0;
+		for (const auto& shard : shards_)
+		{
+			std::lock_guard<std::mutex> lock(shard.mutex);
+			size += shard.strings.size();
+		}
+		return size;
+	}
+
+	template <typename Ch>
+	std::size_t String_pool<Ch>::release_unused()
+	{
+		std::size_t removed = 0;
+		for (auto& shard : shards_)
+		{
+			std::lock_guard<std::mutex> lock(shard.mutex);
+			for (auto it = shard.strings.begin(); it != shard.strings.end();)
+			{
+				// Documents take new references only through intern(), so a string held by the pool alone stays unused
+				if (it->second.use_count() == 1)
+				{
+					it = shard.strings.erase(it);
+					++removed;
+				}
+				else
+				{
+					++it;
+				}
+			}
+		}
+		return removed;
+	}
+
+	namespace detail
+	{
+		template <typename Allocator, typename Ch>
+		auto String_interner<Allocator, Ch>::intern(const Ch* str, std::size_t length) -> const String_type&
+		{
+			const auto it = strings_.find(String_key<Ch>{str, length});
+			if (it != strings_.end())
+			{
+				++it->second.count;
+				return *it->second.handle;
+			}
+			auto handle = pool_->intern(str, length);
+			const auto& string = *handle;
+			strings_.emplace(String_key<Ch>{string.data(), length}, Use{std::move(handle), 1});
+			return string;
+		}
+
+		template <typename Allocator, typename Ch>
+		void String_interner<Allocator, Ch>::release(const Ch* str, std::size_t length)
+		{
+			// Strings not coming from the pool, such as short ones, may have the same characters as a pooled one
+			const auto it = strings_.find(String_key<Ch>{str, length});
+			if (it != strings_.end() && it->second.handle->data() == str && --it->second.count == 0)
+			{
+				strings_.erase(it);
+			}
+		}
+
+		template <typename Allocator, typename Ch>
+		template <typename Json_ref>
+		void String_interner<Allocator, Ch>::set(Json_ref& ref, const Ch* value, std::size_t length)
+		{
+			const Ch* previous = ref.IsString() ? ref.GetString() : nullptr;
+			const std::size_t previous_length = previous ? ref.GetStringLength() : 0;
+			if (inline_string(length))
+			{
+				ref.SetString(value, static_cast<rapidjson::SizeType>(length), allocator());
+			}
+			else
+			{
+				const auto& string = intern(value, length);
+				ref.SetString(rapidjson::StringRef(string.data(), string.size()));
+			}
+			if (previous && !inline_string(previous_length))
+			{
+				release(previous, previous_length);
+			}
+		}
+
+		template <typename Allocator, typename Ch>
+		template <typename Json_ref>
+		void String_interner<Allocator, Ch>::intern_all(Json_ref& ref)
+		{
+			if (ref.IsString())
+			{
+				if (!inline_string(ref.GetStringLength()))
+				{
+					const auto& string = intern(ref.GetString(), ref.GetStringLength());
+					ref.SetString(rapidjson::StringRef(string.data(), string.size()));
+				}
+			}
+			else if (ref.IsObject())
+			{
+				for (auto& member : ref.GetObject())
+				{
+					intern_all(member.value);
+				}
+			}
+			else if (ref.IsArray())
+			{
+				for (auto& element : ref.GetArray())
+				{
+					intern_all(element);
+				}
+			}
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,656 @@
+// Copyright (C) 2017 Andrea Spurio. All rights reserved.
+//
+// Licensed under the MIT License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// http://opensource.org/licenses/MIT
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef JSONTYPE_TAPE_ROOT_HPP_
+#define JSONTYPE_TAPE_ROOT_HPP_
+
+#include <string>
+#include <vector>
+#include <limits>
+#include <iterator>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <rapidjson/reader.h>
+#include <rapidjson/memorystream.h>
+#include <rapidjson/encodedstream.h>
+#include "Root.hpp"
+
+namespace jsontype
+{
+	namespace detail
+	{
+		enum class Tape_type : std::uint8_t
+		{
+			null_value,
+			false_value,
+			true_value,
+			number,
+			string,
+			object,
+			array
+		};
+
+		/**
+		 * Token of a tape. Containers are followed by their content, member names included, and know the index of
+		 * the token following them so that they can be skipped in one step
+		 */
+		struct Tape_entry
+		{
+			// Representations a number fits in, as rapidjson's number flags
+			static constexpr std::uint8_t int_flag = 1;
+			static constexpr std::uint8_t uint_flag = 2;
+			static constexpr std::uint8_t int64_flag = 4;
+			static constexpr std::uint8_t uint64_flag = 8;
+			static constexpr std::uint8_t double_flag = 16;
+
+			Tape_type type;
+			std::uint8_t flags;
+			// Length of a string, number of members or elements of a container
+			std::uint32_t length;
+			// Bits of a number, offset of a string in the string buffer or index of the token after a container
+			std::uint64_t payload;
+		};
+
+		template <typename Encoding>
+		class Tape_builder;
+	}
+
+	/**
+	 * Read-only json document stored as a flat sequence of tokens, with all its strings in a single buffer.
+	 * Walking it reads memory sequentially instead of following the pointers of a DOM
+	 */
+	template <typename Encoding>
+	class Generic_tape
+	{
+	public:
+		using Ch = typename Encoding::Ch;
+
+		/**
+		 * Parses the given json characters into the tape, replacing its content
+		 *
+		 * @throws Bad_structure if the json is not valid
+		 */
+		void parse(const Ch* json, std::size_t length);
+
+		/**
+		 * @returns The number of tokens of the tape
+		 */
+		std::size_t size() const { return entries_.size(); }
+
+		const detail::Tape_entry* entries() const { return entries_.data(); }
+		const Ch* strings() const { return strings_.data(); }
+	private:
+		friend class detail::Tape_builder<Encoding>;
+
+		std::vector<detail::Tape_entry> entries_;
+		std::vector<Ch> strings_;
+	};
+
+	/**
+	 * Handle to a value of a tape, readable through the same member functions as a rapidjson value
+	 */
+	template <typename Encoding>
+	class Tape_ref
+	{
+	public:
+		using Ch = typename Encoding::Ch;
+
+		Tape_ref() = default;
+		Tape_ref(const Generic_tape<Encoding>& tape, std::size_t index)
+				: entries_(tape.entries()), strings_(tape.strings()), index_(index)
+		{}
+
+		/**
+		 * @returns Whether the handle refers to a value, rather than to a member that was not found
+		 */
+		bool valid() const { return entries_ != nullptr; }
+
+		bool IsNull() const { return entry().type == detail::Tape_type::null_value; }
+		bool IsBool() const { return IsTrue() || IsFalse(); }
+		bool IsTrue() const { return entry().type == detail::Tape_type::true_value; }
+		bool IsFalse() const { return entry().type == detail::Tape_type::false_value; }
+		bool IsNumber() const { return entry().type == detail::Tape_type::number; }
+		bool IsInt() const { return has_flag(detail::Tape_entry::int_flag); }
+		bool IsUint() const { return has_flag(detail::Tape_entry::uint_flag); }
+		bool IsInt64() const { return has_flag(detail::Tape_entry::int64_flag); }
+		bool IsUint64() const { return has_flag(detail::Tape_entry::uint64_flag); }
+		bool IsDouble() const { return has_flag(detail::Tape_entry::double_flag); }
+		bool IsFloat() const;
+		bool IsString() const { return entry().type == detail::Tape_type::string; }
+		bool IsObject() const { return entry().type == detail::Tape_type::object; }
+		bool IsArray() const { return entry().type == detail::Tape_type::array; }
+
+		bool GetBool() const { return IsTrue(); }
+		int GetInt() const { return static_cast<int>(GetInt64()); }
+		unsigned GetUint() const { return static_cast<unsigned>(entry().payload); }
+		std::int64_t GetInt64() const { return static_cast<std::int64_t>(entry().payload); }
+		std::uint64_t GetUint64() const { return entry().payload; }
+		double GetDouble() const;
+		float GetFloat() const { return static_cast<float>(GetDouble()); }
+		const Ch* GetString() const { return strings_ + entry().payload; }
+		std::size_t GetStringLength() const { return entry().length; }
+
+		std::size_t MemberCount() const { return entry().length; }
+		std::size_t Size() const { return entry().length; }
+
+		/**
+		 * @returns The element of an array at the given index, which must be less than Size(). The elements before
+		 * it are walked over, so it takes time linear in the index
+		 */
+		Tape_ref operator[](std::size_t index) const;
+
+		/**
+		 * @returns The value following this one in its array
+		 */
+		Tape_ref next_sibling() const { return Tape_ref(entries_, strings_, next(index_)); }
+
+		/**
+		 * @returns The value of an object's member with the given name, or an invalid handle if it's missing
+		 */
+		Tape_ref find_member(const Ch* name, std::size_t length) const;
+	private:
+		Tape_ref(const detail::Tape_entry* entries, const Ch* strings, std::size_t index)
+				: entries_(entries), strings_(strings), index_(index)
+		{}
+
+		const detail::Tape_entry& entry() const { return entries_[index_]; }
+		bool has_flag(std::uint8_t flag) const { return IsNumber() && (entry().flags & flag) != 0; }
+		std::size_t next(std::size_t index) const;
+
+		const detail::Tape_entry* entries_ = nullptr;
+		const Ch* strings_ = nullptr;
+		std::size_t index_ = 0;
+
+		template <typename>
+		friend class Tape_iterator;
+	};
+
+	/**
+	 * Forward iterator over the elements of an array of a tape, stepping over each element in constant time
+	 */
+	template <typename Encoding>
+	class Tape_iterator
+	{
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = Tape_ref<Encoding>;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const Tape_ref<Encoding>*;
+		using reference = const Tape_ref<Encoding>&;
+
+		Tape_iterator() = default;
+		explicit Tape_iterator(const Tape_ref<Encoding>& ref) : ref_(ref) {}
+
+		reference operator*() const { return ref_; }
+		pointer operator->() const { return &ref_; }
+		Tape_iterator& operator++() { ref_ = ref_.next_sibling(); return *this; }
+		Tape_iterator operator++(int) { auto old = *this; ++*this; return old; }
+		bool operator==(const Tape_iterator& other) const { return ref_.index_ == other.ref_.index_; }
+		bool operator!=(const Tape_iterator& other) const { return !(*this == other); }
+	private:
+		Tape_ref<Encoding> ref_;
+	};
+
+	template <typename Payload, typename Encoding>
+	class Tape_object_proxy;
+
+	/**
+	 * Read-only handle to an array of a tape
+	 */
+	template <typename Encoding>
+	class Tape_array_proxy
+	{
+	public:
+		using const_iterator = Tape_iterator<Encoding>;
+
+		explicit Tape_array_proxy(const Tape_ref<Encoding>& ref) : ref_(ref) {}
+
+		std::size_t size() const { return ref_.Size(); }
+		/**
+		 * @returns The element at the given index, found in time linear in the index; iterate to visit them all
+		 */
+		Tape_ref<Encoding> operator[](std::size_t index) const { return ref_[index]; }
+		const_iterator begin() const { return const_iterator(ref_[0]); }
+		const_iterator end() const { return const_iterator(ref_.next_sibling()); }
+		const auto& ref() const { return ref_; }
+	private:
+		Tape_ref<Encoding> ref_;
+	};
+
+	/**
+	 * Read-only handle to a value field of a tape
+	 */
+	template <typename T, typename Encoding>
+	class Tape_value_proxy
+	{
+	public:
+		typedef T Value_type;
+
+		explicit Tape_value_proxy(const Tape_ref<Encoding>& ref) : ref_(ref) {}
+
+		T get() const { return detail::Value_traits<T>::get(ref_); }
+		operator T() const { return get(); }
+		const auto& ref() const { return ref_; }
+	private:
+		Tape_ref<Encoding> ref_;
+	};
+
+	namespace detail
+	{
+		template <typename Payload, typename Encoding> struct Tape_node;
+
+		template <typename Name_tag, typename... Payloads, typename Encoding>
+		struct Tape_node<Object<Name_tag, Payloads...>, Encoding>
+		{
+			using name_tag = Name_tag;
+			using type = Tape_object_proxy<Object<Name_tag, Payloads...>, Encoding>;
+
+			static void check(const Tape_ref<Encoding>& member);
+		};
+
+		template <typename Name_tag, typename... Element, typename Encoding>
+		struct Tape_node<Array<Name_tag, Element...>, Encoding>
+		{
+			using name_tag = Name_tag;
+			using type = Tape_array_proxy<Encoding>;
+
+			static void check(const Tape_ref<Encoding>& member);
+		};
+
+		template <typename Name_tag, typename T, typename Encoding>
+		struct Tape_node<Value_field<Name_tag, T>, Encoding>
+		{
+			using name_tag = Name_tag;
+			using type = Tape_value_proxy<T, Encoding>;
+
+			static void check(const Tape_ref<Encoding>& member);
+		};
+
+		/**
+		 * Checks that an object of a tape has all the members described by the payloads
+		 *
+		 * @throws Bad_structure if a member is missing or of the wrong kind
+		 */
+		template <typename Encoding, typename... Payloads>
+		void tape_structure_check(const Tape_ref<Encoding>& object);
+
+		template <typename Encoding>
+		void tape_check_elements(const Tape_ref<Encoding>&, const char*) {}
+
+		/**
+		 * Checks that every element of an array of a tape is an object with the structure of the payloads
+		 *
+		 * @throws Bad_structure naming the first element which is not
+		 */
+		template <typename Encoding, typename Name_tag, typename... Payloads>
+		void tape_check_elements(const Tape_ref<Encoding>& array, const char* array_name, Object<Name_tag, Payloads...>*);
+
+		template <typename Name_tag, typename Encoding, typename... Payloads>
+		auto tape_find(const Tape_ref<Encoding>& object);
+
+		template <typename Node, typename T>
+		auto tape_unfold(const Node& node, Pack<T>) { return node.find(T{}); }
+
+		template <typename Node, typename T, typename U, typename... Ts>
+		auto tape_unfold(const Node& node, Pack<T, U, Ts...>) { return tape_unfold(node.find(T{}), Pack<U, Ts...>{}); }
+
+		/**
+		 * Reader handler appending the tokens of a json to a tape
+		 */
+		template <typename Encoding>
+		class Tape_builder
+		{
+		public:
+			using Ch = typename Encoding::Ch;
+
+			explicit Tape_builder(Generic_tape<Encoding>& tape) : tape_(tape) {}
+
+			bool Null() { return add(Tape_type::null_value); }
+			bool Bool(bool b) { return add(b ? Tape_type::true_value : Tape_type::false_value); }
+			bool Int(int i) { return Int64(i); }
+			bool Uint(unsigned i) { return Uint64(i); }
+			bool Int64(std::int64_t i);
+			bool Uint64(std::uint64_t i);
+			bool Double(double d);
+			bool RawNumber(const Ch* str, rapidjson::SizeType length, bool copy) { return String(str, length, copy); }
+			bool String(const Ch* str, rapidjson::SizeType length, bool);
+			bool Key(const Ch* str, rapidjson::SizeType length, bool copy) { return String(str, length, copy); }
+			bool StartObject() { return open(Tape_type::object); }
+			bool EndObject(rapidjson::SizeType count) { return close(count); }
+			bool StartArray() { return open(Tape_type::array); }
+			bool EndArray(rapidjson::SizeType count) { return close(count); }
+		private:
+			bool add(Tape_type type, std::uint8_t flags = 0, std::uint32_t length = 0, std::uint64_t payload = 0);
+			bool open(Tape_type type);
+			bool close(rapidjson::SizeType count);
+
+			Generic_tape<Encoding>& tape_;
+			std::vector<std::size_t> open_;
+		};
+	}
+
+	/**
+	 * Read-only handle to an object of a tape
+	 */
+	template <typename Name_tag, typename... Payloads, typename Encoding>
+	class Tape_object_proxy<Object<Name_tag, Payloads...>, Encoding>
+	{
+	public:
+		explicit Tape_object_proxy(const Tape_ref<Encoding>& ref) : ref_(ref) {}
+
+		template <typename Name_tag_search>
+		auto find(Name_tag_search) const { return detail::tape_find<Name_tag_search, Encoding, Payloads...>(ref_); }
+
+		template <typename... K>
+		auto find(Key<K...>) const { return detail::tape_unfold(*this, typename Key<K...>::Args{}); }
+
+		template <typename T>
+		auto operator[](T tag) const { return find(tag); }
+
+		const auto& ref() const { return ref_; }
+	private:
+		Tape_ref<Encoding> ref_;
+	};
+
+	/**
+	 * Read-only root of a json entity stored in a tape rather than in a rapidjson document.
+	 * It offers the same lookups as a const root; members are found by walking the tokens of their object
+	 */
+	template <typename Encoding, typename... Payloads>
+	class Generic_tape_root
+	{
+	public:
+		using Ch = typename Encoding::Ch;
+
+		/**
+		 * Parses the given json string into a tape
+		 *
+		 * @throws Bad_structure if the json string's structure is not compatible with this type
+		 */
+		explicit Generic_tape_root(const std::basic_string<Ch>& json) : Generic_tape_root(json.data(), json.size()) {}
+		/**
+		 * Parses the given json characters into a tape
+		 *
+		 * @throws Bad_structure if the json's structure is not compatible with this type
+		 */
+		Generic_tape_root(const Ch* json, std::size_t length);
+
+		template <typename Name_tag>
+		auto find(Name_tag) const { return detail::tape_find<Name_tag, Encoding, Payloads...>(ref()); }
+
+		template <typename... K>
+		auto find(Key<K...>) const { return detail::tape_unfold(*this, typename Key<K...>::Args{}); }
+
+		template <typename T>
+		auto operator[](T tag) const { return find(tag); }
+
+		/**
+		 * @returns A reference to the underlying tape
+		 */
+		const auto& tape() const { return tape_; }
+		/**
+		 * @returns A handle to the root object of the tape
+		 */
+		Tape_ref<Encoding> ref() const { return Tape_ref<Encoding>(tape_, 0); }
+	private:
+		Generic_tape<Encoding> tape_;
+	};
+
+	// Shortcut for a tape of UTF-8 characters
+	template <typename... Payloads>
+	using Tape_root = Generic_tape_root<rapidjson::UTF8<>, Payloads...>;
+
+	//
+	// Definitions
+	//
+
+	template <typename Encoding>
+	void Generic_tape<Encoding>::parse(const Ch* json, std::size_t length)
+	{
+		entries_.clear();
+		strings_.clear();
+		detail::Tape_builder<Encoding> builder(*this);
+		rapidjson::MemoryStream bytes(reinterpret_cast<const char*>(json), length * sizeof(Ch));
+		rapidjson::EncodedInputStream<Encoding, rapidjson::MemoryStream> stream(bytes);
+		rapidjson::GenericReader<Encoding, Encoding> reader;
+		if (reader.Parse(stream, builder).IsError())
+		{
+			throw Bad_structure(std::string("Not a valid json"));
+		}
+	}
+
+	template <typename Encoding>
+	bool Tape_ref<Encoding>::IsFloat() const
+	{
+		if (!IsDouble())
+		{
+			return false;
+		}
+		const double d = GetDouble();
+		return d >= -std::numeric_limits<float>::max() && d <= std::numeric_limits<float>::max();
+	}
+
+	template <typename Encoding>
+	double Tape_ref<Encoding>::GetDouble() const
+	{
+		if (IsDouble())
+		{
+			double d;
+			std::memcpy(&d, &entry().payload, sizeof(d));
+			return d;
+		}
+		return IsInt64() ? static_cast<double>(GetInt64()) : static_cast<double>(GetUint64());
+	}
+
+	template <typename Encoding>
+	Tape_ref<Encoding> Tape_ref<Encoding>::operator[](std::size_t index) const
+	{
+		std::size_t element = index_ + 1;
+		for (; index > 0; --index)
+		{
+			element = next(element);
+		}
+		return Tape_ref(entries_, strings_, element);
+	}
+
+	template <typename Encoding>
+	Tape_ref<Encoding> Tape_ref<Encoding>::find_member(const Ch* name, std::size_t length) const
+	{
+		std::size_t member = index_ + 1;
+		for (std::size_t i = 0; i < entry().length; ++i)
+		{
+			const auto& key = entries_[member];
+			if (key.length == length && std::char_traits<Ch>::compare(strings_ + key.payload, name, length) == 0)
+			{
+				return Tape_ref(entries_, strings_, member + 1);
+			}
+			member = next(member + 1);
+		}
+		return Tape_ref();
+	}
+
+	template <typename Encoding>
+	std::size_t Tape_ref<Encoding>::next(std::size_t index) const
+	{
+		const auto& token = entries_[index];
+		return token.type == detail::Tape_type::object || token.type == detail::Tape_type::array
+				? static_cast<std::size_t>(token.payload) : index + 1;
+	}
+
+	template <typename Encoding, typename... Payloads>
+	Generic_tape_root<Encoding, Payloads...>::Generic_tape_root(const Ch* json, std::size_t length)
+	{
+		tape_.parse(json, length);
+		if (!ref().IsObject())
+		{
+			throw Bad_structure(std::string("Not a valid json"));
+		}
+		detail::tape_structure_check<Encoding, Payloads...>(ref());
+	}
+
+	namespace detail
+	{
+		template <typename Encoding, typename... Payloads>
+		void tape_structure_check(const Tape_ref<Encoding>& object)
+		{
+			using Expander = int[];
+			(void)Expander{0, (Tape_node<Payloads, Encoding>::check(object.find_member(
+					Tape_node<Payloads, Encoding>::name_tag::name(), Tape_node<Payloads, Encoding>::name_tag::length())),
+					0)...};
+		}
+
+		template <typename Name_tag, typename Encoding, typename... Payloads>
+		auto tape_find(const Tape_ref<Encoding>& object)
+		{
+			static_assert(is_tag<Name_tag>(), "Name tag template argument must be a tag class");
+			using Payload = typename Payload_finder<Name_tag, Payloads...>::type;
+			static_assert(!std::is_same<Payload, No_result>::value, "No member with this name in the structure");
+			return typename Tape_node<Payload, Encoding>::type(object.find_member(Name_tag::name(), Name_tag::length()));
+		}
+
+		template <typename Name_tag, typename... Payloads, typename Encoding>
+		void Tape_node<Object<Name_tag, Payloads...>, Encoding>::check(const Tape_ref<Encoding>& member)
+		{
+			if (!member.valid())
+			{
+				throw Bad_structure(std::string("Missing object member: ") + Name_tag::name());
+			}
+			if (!member.IsObject())
+			{
+				throw Bad_structure(std::string(Name_tag::name()) + " is not an object");
+			}
+			tape_structure_check<Encoding, Payloads...>(member);
+		}
+
+		template <typename Name_tag, typename... Element, typename Encoding>
+		void Tape_node<Array<Name_tag, Element...>, Encoding>::check(const Tape_ref<Encoding>& member)
+		{
+			if (!member.valid())
+			{
+				throw Bad_structure(std::string("Missing array member: ") + Name_tag::name());
+			}
+			if (!member.IsArray())
+			{
+				throw Bad_structure(std::string(Name_tag::name()) + " is not an array");
+			}
+			tape_check_elements(member, Name_tag::name(), static_cast<Element*>(nullptr)...);
+		}
+
+		template <typename Encoding, typename Name_tag, typename... Payloads>
+		void tape_check_elements(const Tape_ref<Encoding>& array, const char* array_name, Object<Name_tag, Payloads...>*)
+		{
+			auto element = array[0];
+			for (std::size_t i = 0; i < array.Size(); ++i, element = element.next_sibling())
+			{
+				try
+				{
+					if (!element.IsObject())
+					{
+						throw Bad_structure(std::string(Name_tag::name()) + " is not an object");
+					}
+					tape_structure_check<Encoding, Payloads...>(element);
+				}
+				catch (const Bad_structure& e)
+				{
+					throw Bad_structure("Element " + std::to_string(i) + " of " + array_name + ": " + e.what());
+				}
+			}
+		}
+
+		template <typename Name_tag, typename T, typename Encoding>
+		void Tape_node<Value_field<Name_tag, T>, Encoding>::check(const Tape_ref<Encoding>& member)
+		{
+			if (!member.valid())
+			{
+				throw Bad_structure(std::string("Missing value member: ") + Name_tag::name());
+			}
+			if (!Value_traits<T>::check(member))
+			{
+				throw Bad_structure("Value of " + std::string(Name_tag::name()) + " is of the wrong type");
+			}
+		}
+
+		template <typename Encoding>
+		bool Tape_builder<Encoding>::Int64(std::int64_t i)
+		{
+			std::uint8_t flags = Tape_entry::int64_flag;
+			if (i >= std::numeric_limits<int>::min() && i <= std::numeric_limits<int>::max())
+			{
+				flags |= Tape_entry::int_flag;
+			}
+			if (i >= 0)
+			{
+				flags |= Tape_entry::uint64_flag;
+				if (static_cast<std::uint64_t>(i) <= std::numeric_limits<unsigned>::max())
+				{
+					flags |= Tape_entry::uint_flag;
+				}
+			}
+			return add(Tape_type::number, flags, 0, static_cast<std::uint64_t>(i));
+		}
+
+		template <typename Encoding>
+		bool Tape_builder<Encoding>::Uint64(std::uint64_t i)
+		{
+			if (i <= static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max()))
+			{
+				return Int64(static_cast<std::int64_t>(i));
+			}
+			return add(Tape_type::number, Tape_entry::uint64_flag, 0, i);
+		}
+
+		template <typename Encoding>
+		bool Tape_builder<Encoding>::Double(double d)
+		{
+			std::uint64_t bits;
+			std::memcpy(&bits, &d, sizeof(bits));
+			return add(Tape_type::number, Tape_entry::double_flag, 0, bits);
+		}
+
+		template <typename Encoding>
+		bool Tape_builder<Encoding>::String(const Ch* str, rapidjson::SizeType length, bool)
+		{
+			const auto offset = tape_.strings_.size();
+			tape_.strings_.insert(tape_.strings_.end(), str, str + length);
+			tape_.strings_.push_back(Ch());
+			return add(Tape_type::string, 0, length, offset);
+		}
+
+		template <typename Encoding>
+		bool Tape_builder<Encoding>::add(Tape_type type, std::uint8_t flags, std::uint32_t length, std::uint64_t payload)
+		{
+			tape_.entries_.push_back(Tape_entry{type, flags, length, payload});
+			return true;
+		}
+
+		template <typename Encoding>
+		bool Tape_builder<Encoding>::open(Tape_type type)
+		{
+			open_.push_back(tape_.entries_.size());
+			return add(type);
+		}
+
+		template <typename Encoding>
+		bool Tape_builder<Encoding>::close(rapidjson::SizeType count)
+		{
+			auto& container = tape_.entries_[open_.back()];
+			open_.pop_back();
+			container.length = count;
+			container.payload = tape_.entries_.size();
+			return true;
+		}
+	}
+}
+
+#endif
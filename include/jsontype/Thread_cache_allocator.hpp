@@ -0,0 +1,278 @@
+// Copyright (C) 2017 Andrea Spurio. All rights reserved.
+//
+// Licensed under the MIT License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// http://opensource.org/licenses/MIT
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef JSONTYPE_THREAD_CACHE_ALLOCATOR_HPP_
+#define JSONTYPE_THREAD_CACHE_ALLOCATOR_HPP_
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <rapidjson/document.h>
+#include <rapidjson/allocators.h>
+#include "Root.hpp"
+
+namespace jsontype
+{
+	namespace detail
+	{
+		/**
+		 * Blocks released by the calling thread, kept in a few free lists of blocks with the same capacity
+		 */
+		template <std::size_t Max_retained>
+		class Thread_cache
+		{
+		public:
+			/**
+			 * @returns The cache of the calling thread, or a null pointer if the thread is exiting
+			 */
+			static Thread_cache* local();
+
+			Thread_cache() { current() = this; }
+			~Thread_cache();
+			Thread_cache(const Thread_cache&) = delete;
+			Thread_cache& operator=(const Thread_cache&) = delete;
+
+			/**
+			 * @returns A cached block with the given capacity, or a null pointer if there's none
+			 */
+			void* take(std::size_t capacity);
+
+			/**
+			 * Keeps a block for later, unless the cache is full
+			 *
+			 * @returns Whether the block was kept
+			 */
+			bool give(void* block, std::size_t capacity);
+
+			std::size_t retained() const { return retained_; }
+		private:
+			struct Free_block
+			{
+				Free_block* next;
+			};
+
+			struct Bucket
+			{
+				std::size_t capacity = 0;
+				Free_block* head = nullptr;
+			};
+
+			static constexpr std::size_t bucket_count = 8;
+
+			// Trivially destructible, so it can still be read after the cache is gone
+			static Thread_cache*& current()
+			{
+				static thread_local Thread_cache* cache = nullptr;
+				return cache;
+			}
+
+			Bucket buckets_[bucket_count];
+			std::size_t retained_ = 0;
+		};
+	}
+
+	/**
+	 * Base allocator for rapidjson's pool allocator and parse stack, which keeps the blocks released by a thread
+	 * to serve the next requests of the same thread.
+	 * Sizes are rounded up to whole pages, so the chunks of every document fall in the same few free lists; at
+	 * most Max_retained bytes are kept by each thread and the rest goes back to the global heap
+	 */
+	template <std::size_t Max_retained = 4 * 1024 * 1024>
+	class Thread_cache_allocator
+	{
+	public:
+		static const bool kNeedFree = true;
+
+		void* Malloc(std::size_t size);
+		void* Realloc(void* original, std::size_t original_size, std::size_t new_size);
+		static void Free(void* ptr);
+
+		/**
+		 * @returns The number of bytes kept by the calling thread for later requests
+		 */
+		static std::size_t retained();
+	private:
+		using Cache = detail::Thread_cache<Max_retained>;
+
+		// Keeps the blocks aligned as the ones of malloc
+		struct alignas(alignof(std::max_align_t)) Header
+		{
+			std::size_t capacity;
+		};
+
+		static constexpr std::size_t page_size = 4096;
+
+		static Header* header(void* ptr) { return static_cast<Header*>(ptr) - 1; }
+	};
+
+	// Shortcut for a rapidjson document whose memory comes from the thread cache
+	using Thread_cached_document = rapidjson::GenericDocument<rapidjson::UTF8<>,
+			rapidjson::MemoryPoolAllocator<Thread_cache_allocator<>>,
+			Thread_cache_allocator<>>;
+
+	// Shortcut for a root whose memory comes from the thread cache
+	template <typename... Payloads>
+	using Thread_cached_root = Generic_root<Thread_cached_document, Payloads...>;
+
+	//
+	// Definitions
+	//
+
+	template <std::size_t Max_retained>
+	void* Thread_cache_allocator<Max_retained>::Malloc(std::size_t size)
+	{
+		if (size == 0)
+		{
+			return nullptr;
+		}
+		const auto capacity = (size + sizeof(Header) + page_size - 1) / page_size * page_size - sizeof(Header);
+		auto cache = Cache::local();
+		void* block = cache ? cache->take(capacity) : nullptr;
+		if (!block)
+		{
+			block = std::malloc(capacity + sizeof(Header));
+			if (!block)
+			{
+				return nullptr;
+			}
+		}
+		const auto head = static_cast<Header*>(block);
+		head->capacity = capacity;
+		return head + 1;
+	}
+
+	template <std::size_t Max_retained>
+	void* Thread_cache_allocator<Max_retained>::Realloc(void* original, std::size_t original_size, std::size_t new_size)
+	{
+		if (!original)
+		{
+			return Malloc(new_size);
+		}
+		if (new_size == 0)
+		{
+			Free(original);
+			return nullptr;
+		}
+		if (new_size <= header(original)->capacity)
+		{
+			return original;
+		}
+		void* ptr = Malloc(new_size);
+		if (ptr)
+		{
+			std::memcpy(ptr, original, original_size < new_size ? original_size : new_size);
+			Free(original);
+		}
+		return ptr;
+	}
+
+	template <std::size_t Max_retained>
+	void Thread_cache_allocator<Max_retained>::Free(void* ptr)
+	{
+		if (!ptr)
+		{
+			return;
+		}
+		const auto head = header(ptr);
+		auto cache = Cache::local();
+		if (!cache || !cache->give(head, head->capacity))
+		{
+			std::free(head);
+		}
+	}
+
+	template <std::size_t Max_retained>
+	std::size_t Thread_cache_allocator<Max_retained>::retained()
+	{
+		const auto cache = Cache::local();
+		return cache ? cache->retained() : 0;
+	}
+
+	namespace detail
+	{
+		template <std::size_t Max_retained>
+		Thread_cache<Max_retained>* Thread_cache<Max_retained>::local()
+		{
+			static thread_local bool created = false;
+			if (!created)
+			{
+				created = true;
+				static thread_local Thread_cache cache;
+			}
+			return current();
+		}
+
+		template <std::size_t Max_retained>
+		Thread_cache<Max_retained>::~Thread_cache()
+		{
+			current() = nullptr;
+			for (auto& bucket : buckets_)
+			{
+				while (bucket.head)
+				{
+					const auto next = bucket.head->next;
+					std::free(bucket.head);
+					bucket.head = next;
+				}
+			}
+		}
+
+		template <std::size_t Max_retained>
+		void* Thread_cache<Max_retained>::take(std::size_t capacity)
+		{
+			for (auto& bucket : buckets_)
+			{
+				if (bucket.capacity == capacity && bucket.head)
+				{
+					const auto block = bucket.head;
+					bucket.head = block->next;
+					retained_ -= capacity;
+					return block;
+				}
+			}
+			return nullptr;
+		}
+
+		template <std::size_t Max_retained>
+		bool Thread_cache<Max_retained>::give(void* block, std::size_t capacity)
+		{
+			if (retained_ + capacity > Max_retained)
+			{
+				return false;
+			}
+			Bucket* free_bucket = nullptr;
+			for (auto& bucket : buckets_)
+			{
+				if (bucket.capacity == capacity)
+				{
+					free_bucket = &bucket;
+					break;
+				}
+				if (!free_bucket && !bucket.head)
+				{
+					free_bucket = &bucket;
+				}
+			}
+			if (!free_bucket)
+			{
+				return false;
+			}
+			free_bucket->capacity = capacity;
+			free_bucket->head = new (block) Free_block{free_bucket->head};
+			retained_ += capacity;
+			return true;
+		}
+	}
+}
+
+#endif
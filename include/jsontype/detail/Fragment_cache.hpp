@@ -0,0 +1,158 @@
+// Copyright (C) 2017 Andrea Spurio. All rights reserved.
+//
+// Licensed under the MIT License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// http://opensource.org/licenses/MIT
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef JSONTYPE_DETAIL_FRAGMENT_CACHE_HPP_
+#define JSONTYPE_DETAIL_FRAGMENT_CACHE_HPP_
+
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include <rapidjson/writer.h>
+#include <rapidjson/stringbuffer.h>
+#include "Encoding_traits.hpp"
+
+namespace jsontype
+{
+	namespace detail
+	{
+		/**
+		 * Remembers the serialized form of json objects and which values were modified since the last
+		 * serialization. Objects are identified by the address of their member array, which the pool allocator
+		 * never reuses.
+		 */
+		template <typename Allocator, typename Ch>
+		class Fragment_cache
+		{
+		public:
+			using String_type = typename Character_traits<Ch>::String_type;
+
+			void bind(Allocator& alloc) { alloc_ = &alloc; }
+			Allocator& allocator() const { return *alloc_; }
+
+			void mark_dirty(const void* node) { dirty_.insert(node); }
+			void clear_dirty() { dirty_.clear(); }
+			/**
+			 * Forgets all the fragments, needed when the objects are moved to a different allocator
+			 */
+			void clear() { dirty_.clear(); fragments_.clear(); }
+
+			template <typename Json_ref>
+			bool dirty_within(const Json_ref&) const;
+
+			template <typename Json_ref>
+			const String_type* find(const Json_ref&) const;
+
+			template <typename Json_ref>
+			void store(const Json_ref& object, const Ch* fragment, std::size_t length);
+		private:
+			template <typename Json_ref>
+			static const void* key(const Json_ref& object) { return &*object.MemberBegin(); }
+
+			Allocator* alloc_ = nullptr;
+			std::unordered_set<const void*> dirty_;
+			std::unordered_map<const void*, String_type> fragments_;
+		};
+
+		template <typename Alloc>
+		Alloc& base_alloc(Alloc& alloc) { return alloc; }
+
+		template <typename Allocator, typename Ch>
+		Allocator& base_alloc(Fragment_cache<Allocator, Ch>& cache) { return cache.allocator(); }
+
+		template <typename Alloc, typename Json_ref>
+		void mark_dirty(Alloc&, const Json_ref&) {}
+
+		template <typename Allocator, typename Ch, typename Json_ref>
+		void mark_dirty(Fragment_cache<Allocator, Ch>& cache, const Json_ref& ref) { cache.mark_dirty(&ref); }
+
+		/**
+		 * Serializes the given object again if it has no cached fragment or one of its members was modified,
+		 * splicing in the cached fragments of its children.
+		 *
+		 * @returns Whether the object's fragment changed
+		 */
+		template <typename Json_ref, typename Cache>
+		bool refresh_fragment(const Json_ref& object, Cache& cache)
+		{
+			if (object.MemberCount() == 0 || (cache.find(object) && !cache.dirty_within(object)))
+			{
+				return false;
+			}
+			using namespace rapidjson;
+			GenericStringBuffer<typename Json_ref::EncodingType> buffer;
+			Writer<decltype(buffer)> writer(buffer);
+			writer.StartObject();
+			for (const auto& member : object.GetObject())
+			{
+				writer.Key(member.name.GetString(), member.name.GetStringLength());
+				const auto fragment = member.value.IsObject() ? cache.find(member.value) : nullptr;
+				if (fragment)
+				{
+					writer.RawValue(fragment->data(), fragment->size(), kObjectType);
+				}
+				else
+				{
+					member.value.Accept(writer);
+				}
+			}
+			writer.EndObject(object.MemberCount());
+			cache.store(object, buffer.GetString(), buffer.GetSize() / sizeof(typename Json_ref::Ch));
+			return true;
+		}
+
+		//
+		// Definitions
+		//
+
+		template <typename Allocator, typename Ch>
+		template <typename Json_ref>
+		bool Fragment_cache<Allocator, Ch>::dirty_within(const Json_ref& object) const
+		{
+			if (object.MemberCount() == 0)
+			{
+				return false;
+			}
+			const auto first = &*object.MemberBegin();
+			const auto last = first + object.MemberCount();
+			const std::less<const void*> less;
+			for (const auto node : dirty_)
+			{
+				if (!less(node, first) && less(node, last))
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+
+		template <typename Allocator, typename Ch>
+		template <typename Json_ref>
+		auto Fragment_cache<Allocator, Ch>::find(const Json_ref& object) const -> const String_type*
+		{
+			if (object.MemberCount() == 0)
+			{
+				return nullptr;
+			}
+			const auto it = fragments_.find(key(object));
+			return it != fragments_.cend() ? &it->second : nullptr;
+		}
+
+		template <typename Allocator, typename Ch>
+		template <typename Json_ref>
+		void Fragment_cache<Allocator, Ch>::store(const Json_ref& object, const Ch* fragment, std::size_t length)
+		{
+			fragments_[key(object)].assign(fragment, length);
+		}
+	}
+}
+
+#endif
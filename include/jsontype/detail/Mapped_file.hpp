@@ -0,0 +1,122 @@
+// Copyright (C) 2017 Andrea Spurio. All rights reserved.
+//
+// Licensed under the MIT License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// http://opensource.org/licenses/MIT
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef JSONTYPE_DETAIL_MAPPED_FILE_HPP_
+#define JSONTYPE_DETAIL_MAPPED_FILE_HPP_
+
+#include <string>
+#include <cstddef>
+#include <cerrno>
+#include <system_error>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define JSONTYPE_HAS_MMAP 1
+#else
+#include <fstream>
+#include <iterator>
+#include <vector>
+#endif
+
+namespace jsontype
+{
+	namespace detail
+	{
+		/**
+		 * Read only view over the whole content of a file.
+		 * The file is memory mapped where the platform allows it, otherwise it's read into memory.
+		 */
+		class Mapped_file
+		{
+		public:
+			/**
+			 * @throws std::system_error if the file can't be opened or mapped
+			 */
+			explicit Mapped_file(const std::string& path);
+			Mapped_file(const Mapped_file&) = delete;
+			Mapped_file& operator=(const Mapped_file&) = delete;
+			~Mapped_file();
+
+			const char* data() const { return data_; }
+			std::size_t size() const { return size_; }
+		private:
+			const char* data_ = nullptr;
+			std::size_t size_ = 0;
+#ifndef JSONTYPE_HAS_MMAP
+			std::vector<char> content_;
+#endif
+		};
+
+		//
+		// Definitions
+		//
+
+#ifdef JSONTYPE_HAS_MMAP
+		inline Mapped_file::Mapped_file(const std::string& path)
+		{
+			const int fd = ::open(path.c_str(), O_RDONLY);
+			if (fd < 0)
+			{
+				throw std::system_error(errno, std::generic_category(), "Cannot open " + path);
+			}
+			struct stat info;
+			if (::fstat(fd, &info) != 0)
+			{
+				const int error = errno;
+				::close(fd);
+				throw std::system_error(error, std::generic_category(), "Cannot stat " + path);
+			}
+			size_ = static_cast<std::size_t>(info.st_size);
+			if (size_ > 0)
+			{
+				void* address = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+				if (address == MAP_FAILED)
+				{
+					const int error = errno;
+					::close(fd);
+					throw std::system_error(error, std::generic_category(), "Cannot map " + path);
+				}
+				::madvise(address, size_, MADV_SEQUENTIAL);
+				data_ = static_cast<const char*>(address);
+			}
+			::close(fd);
+		}
+
+		inline Mapped_file::~Mapped_file()
+		{
+			if (data_)
+			{
+				::munmap(const_cast<char*>(data_), size_);
+			}
+		}
+#else
+		inline Mapped_file::Mapped_file(const std::string& path)
+		{
+			std::ifstream file(path, std::ios::binary);
+			if (!file)
+			{
+				throw std::system_error(errno, std::generic_category(), "Cannot open " + path);
+			}
+			content_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+			data_ = content_.data();
+			size_ = content_.size();
+		}
+
+		inline Mapped_file::~Mapped_file() {}
+#endif
+	}
+}
+
+#endif
@@ -0,0 +1,177 @@
+// Copyright (C) 2017 Andrea Spurio. All rights reserved.
+//
+// Licensed under the MIT License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// http://opensource.org/licenses/MIT
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef JSONTYPE_DETAIL_PHASE_COUNTERS_HPP_
+#define JSONTYPE_DETAIL_PHASE_COUNTERS_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+namespace jsontype
+{
+	/**
+	 * Steps of the life of a root measured by the timed roots
+	 */
+	enum class Root_phase
+	{
+		parse,
+		structure_check,
+		find,
+		set,
+		stringify
+	};
+
+	/**
+	 * Number of calls and cycles spent in each phase by the roots of a type, summed over all threads
+	 */
+	struct Phase_statistics
+	{
+		static constexpr std::size_t phase_count = 5;
+
+		struct Phase
+		{
+			std::uint64_t calls;
+			std::uint64_t cycles;
+		};
+
+		Phase phases[phase_count];
+
+		const Phase& operator[](Root_phase phase) const { return phases[static_cast<std::size_t>(phase)]; }
+	};
+
+	namespace detail
+	{
+		/**
+		 * @returns The processor's time stamp counter where available, nanoseconds of a steady clock elsewhere
+		 */
+		inline std::uint64_t cycle_count()
+		{
+#if defined(__x86_64__) || defined(__i386__) || (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86)))
+			return __rdtsc();
+#else
+			return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+					std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+		}
+
+		/**
+		 * Counters of a single thread. Only the owning thread writes them, so they're updated without
+		 * read-modify-write operations and can be read by any thread
+		 */
+		class Phase_counters
+		{
+		public:
+			void add(Root_phase phase, std::uint64_t cycles)
+			{
+				const auto i = static_cast<std::size_t>(phase);
+				calls_[i].store(calls_[i].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+				cycles_[i].store(cycles_[i].load(std::memory_order_relaxed) + cycles, std::memory_order_relaxed);
+			}
+
+			void add_to(Phase_statistics& statistics) const
+			{
+				for (std::size_t i = 0; i < Phase_statistics::phase_count; ++i)
+				{
+					statistics.phases[i].calls += calls_[i].load(std::memory_order_relaxed);
+					statistics.phases[i].cycles += cycles_[i].load(std::memory_order_relaxed);
+				}
+			}
+		private:
+			std::atomic<std::uint64_t> calls_[Phase_statistics::phase_count] = {};
+			std::atomic<std::uint64_t> cycles_[Phase_statistics::phase_count] = {};
+		};
+
+		/**
+		 * Counters of the roots of type Schema, one set for each thread that used them. The counters of a thread
+		 * are kept after the thread exits
+		 */
+		template <typename Schema>
+		class Phase_registry
+		{
+		public:
+			static Phase_counters& local()
+			{
+				static thread_local const std::shared_ptr<Phase_counters> counters = add();
+				return *counters;
+			}
+
+			static Phase_statistics snapshot();
+		private:
+			struct Shared
+			{
+				std::mutex mutex;
+				std::vector<std::shared_ptr<Phase_counters>> counters;
+			};
+
+			static Shared& shared()
+			{
+				static Shared shared;
+				return shared;
+			}
+
+			static std::shared_ptr<Phase_counters> add();
+		};
+
+		/**
+		 * Adds the cycles elapsed between its construction and its destruction to a phase
+		 */
+		class Phase_timer
+		{
+		public:
+			Phase_timer(Phase_counters& counters, Root_phase phase)
+					: counters_(counters), phase_(phase), start_(cycle_count())
+			{}
+			~Phase_timer() { counters_.add(phase_, cycle_count() - start_); }
+			Phase_timer(const Phase_timer&) = delete;
+			Phase_timer& operator=(const Phase_timer&) = delete;
+		private:
+			Phase_counters& counters_;
+			const Root_phase phase_;
+			const std::uint64_t start_;
+		};
+
+		template <typename Schema>
+		Phase_statistics Phase_registry<Schema>::snapshot()
+		{
+			Phase_statistics statistics{};
+			auto& registry = shared();
+			std::lock_guard<std::mutex> lock(registry.mutex);
+			for (const auto& counters : registry.counters)
+			{
+				counters->add_to(statistics);
+			}
+			return statistics;
+		}
+
+		template <typename Schema>
+		std::shared_ptr<Phase_counters> Phase_registry<Schema>::add()
+		{
+			auto counters = std::make_shared<Phase_counters>();
+			auto& registry = shared();
+			std::lock_guard<std::mutex> lock(registry.mutex);
+			registry.counters.push_back(counters);
+			return counters;
+		}
+	}
+}
+
+#endif
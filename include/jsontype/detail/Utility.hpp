@@ -14,6 +14,8 @@
 #define JSONTYPE_DETAIL_UTILITY_HPP_
 
 #include <type_traits>
+#include <cstddef>
+#include <cstdint>
 
 namespace jsontype
 {
@@ -25,6 +27,35 @@ namespace jsontype
 		struct No_type {};
 
 		struct No_result {};
+
+		template <typename Ch>
+		constexpr std::size_t string_length(const Ch* str)
+		{
+			std::size_t length = 0;
+			while (str[length] != Ch())
+			{
+				++length;
+			}
+			return length;
+		}
+
+		/// FNV-1a hash of a string, usable in constant expressions
+		template <typename Ch>
+		constexpr std::size_t string_hash(const Ch* str, std::size_t length)
+		{
+			std::uint64_t hash = 14695981039346656037ull;
+			for (std::size_t i = 0; i < length; ++i)
+			{
+				hash = (hash ^ static_cast<std::make_unsigned_t<Ch>>(str[i])) * 1099511628211ull;
+			}
+			return static_cast<std::size_t>(hash);
+		}
+
+		/// Mixes a hash into a seed, in the manner of boost::hash_combine
+		constexpr std::size_t hash_combine(std::size_t seed, std::size_t hash)
+		{
+			return seed ^ (hash + static_cast<std::size_t>(0x9e3779b97f4a7c15ull) + (seed << 6) + (seed >> 2));
+		}
 	}
 }
 
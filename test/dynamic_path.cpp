@@ -0,0 +1,77 @@
+#include "gtest/gtest.h"
+#include "jsontype/Root.hpp"
+#include "jsontype/Dynamic_path.hpp"
+#include <string>
+#include <stdexcept>
+
+using namespace jsontype;
+
+namespace
+{
+	JSONTYPE_MAKE_TAG(name);
+	JSONTYPE_MAKE_TAG(contact);
+	JSONTYPE_MAKE_TAG(address);
+	JSONTYPE_MAKE_TAG(phones);
+
+	using Person = Root<Value_field<name_tag, std::string>,
+			Object<contact_tag, Value_field<address_tag, std::string>, Array<phones_tag>>>;
+	using Path = Dynamic_path<Person>;
+
+	const std::string person_json("{\"name\":\"Paul\",\"contact\":{\"address\":\"74 Green St\",\"phones\":[\"123\",\"456\"],"
+			"\"a/b~c\":1}}");
+}
+
+TEST(DYNAMIC_PATH, DOTTED)
+{
+	const Person person(person_json);
+	const Path address("contact.address");
+	EXPECT_EQ(2u, address.size());
+	EXPECT_TRUE(address.described());
+	ASSERT_NE(nullptr, address.find(person));
+	EXPECT_STREQ("74 Green St", address.find(person)->GetString());
+
+	const Path phone("contact.phones.1");
+	EXPECT_FALSE(phone.described());
+	ASSERT_NE(nullptr, phone.find(person));
+	EXPECT_STREQ("456", phone.find(person)->GetString());
+
+	EXPECT_EQ(person.ref(), *Path("").find(person));
+	EXPECT_EQ(nullptr, Path("contact.phones.2").find(person));
+	EXPECT_EQ(nullptr, Path("contact.phones.01").find(person));
+	EXPECT_EQ(nullptr, Path("contact.email").find(person));
+	EXPECT_STREQ("74 Green St", Path("address").find(person.ref()["contact"])->GetString());
+	EXPECT_EQ(nullptr, Path("address.street").find(person.ref()["contact"]));
+}
+
+TEST(DYNAMIC_PATH, POINTER)
+{
+	const Person person(person_json);
+	const Path address("/contact/address");
+	EXPECT_TRUE(address.described());
+	EXPECT_STREQ("74 Green St", address.find(person)->GetString());
+	EXPECT_STREQ("123", Path("/contact/phones/0").find(person)->GetString());
+	EXPECT_EQ(1, Path("/contact/a~1b~0c").find(person)->GetInt());
+	EXPECT_THROW(Path("/contact/a~2"), std::invalid_argument);
+	EXPECT_THROW(Path("/contact/a~"), std::invalid_argument);
+}
+
+TEST(DYNAMIC_PATH, SCHEMA_CHECK)
+{
+	EXPECT_THROW(Path("name.first"), Bad_structure);
+	EXPECT_THROW(Path("/contact/address/street"), Bad_structure);
+	EXPECT_TRUE(Path("contact").described());
+	EXPECT_TRUE(Path("contact.phones").described());
+	EXPECT_FALSE(Path("email.address").described());
+	EXPECT_FALSE(Path("contact.email").described());
+}
+
+TEST(DYNAMIC_PATH, MEMBER_ORDER)
+{
+	const Person person("{\"contact\":{\"phones\":[],\"address\":\"Elm St\"},\"name\":\"Ann\"}");
+	const Path address("contact.address");
+	EXPECT_STREQ("Elm St", address.find(person)->GetString());
+	EXPECT_STREQ("Ann", Path("name").find(person)->GetString());
+
+	const Person other;
+	EXPECT_STREQ("", address.find(other)->GetString());
+}
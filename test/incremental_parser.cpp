@@ -0,0 +1,124 @@
+#include "gtest/gtest.h"
+#include "jsontype/Root.hpp"
+#include "jsontype/Incremental_parser.hpp"
+#include <string>
+#include <cstdint>
+#include <clocale>
+
+using namespace jsontype;
+
+namespace
+{
+	JSONTYPE_MAKE_TAG(id);
+	JSONTYPE_MAKE_TAG(text);
+	JSONTYPE_MAKE_TAG(big);
+	JSONTYPE_MAKE_TAG(ratio);
+	JSONTYPE_MAKE_TAG(flags);
+	JSONTYPE_MAKE_TAG(author);
+	JSONTYPE_MAKE_TAG(name);
+	JSONTYPE_MAKE_TAG(active);
+
+	using Message = Root<Value_field<id_tag, int>,
+			Value_field<text_tag, std::string>,
+			Value_field<big_tag, uint64_t>,
+			Value_field<ratio_tag, double>,
+			Array<flags_tag>,
+			Object<author_tag, Value_field<name_tag, std::string>, Value_field<active_tag, bool>>>;
+	using author_name = Key<author_tag, name_tag>;
+	using author_active = Key<author_tag, active_tag>;
+
+	const std::string message_json("{ \"id\" : -12, \"text\":\"a \\\"quoted\\\" \\u00e8\\ud83d\\ude00\\n\","
+			"\"big\":18446744073709551615,\"ratio\":-2.5e-1,\"flags\":[true,false,null,[],{}],"
+			"\"author\":{\"name\":\"Ann\",\"active\":true},\"extra\":[1,2.0,\"3\"]}");
+
+	void expect_message(const Message& message)
+	{
+		EXPECT_EQ(-12, message[id_tag{}]);
+		EXPECT_EQ("a \"quoted\" \xC3\xA8\xF0\x9F\x98\x80\n", message[text_tag{}].get());
+		EXPECT_EQ(18446744073709551615u, message[big_tag{}].get());
+		EXPECT_DOUBLE_EQ(-0.25, message[ratio_tag{}]);
+		EXPECT_EQ("[true,false,null,[],{}]", message[flags_tag{}].stringify());
+		EXPECT_EQ("Ann", message[author_name{}].get());
+		EXPECT_TRUE(message[author_active{}]);
+	}
+}
+
+TEST(INCREMENTAL_PARSER, WHOLE)
+{
+	Incremental_parser<Message> parser;
+	EXPECT_EQ(message_json.size(), parser.feed(message_json));
+	ASSERT_TRUE(parser.done());
+	expect_message(parser.take());
+}
+
+TEST(INCREMENTAL_PARSER, CHUNKS)
+{
+	for (std::size_t chunk = 1; chunk <= 7; ++chunk)
+	{
+		Incremental_parser<Message> parser;
+		for (std::size_t i = 0; i < message_json.size(); i += chunk)
+		{
+			EXPECT_FALSE(parser.done());
+			parser.feed(message_json.data() + i, std::min(chunk, message_json.size() - i));
+		}
+		ASSERT_TRUE(parser.done());
+		expect_message(parser.take());
+	}
+}
+
+TEST(INCREMENTAL_PARSER, CONSECUTIVE_DOCUMENTS)
+{
+	const std::string stream(message_json + "\n" + message_json);
+	Incremental_parser<Message> parser;
+
+	const auto consumed = parser.feed(stream);
+	EXPECT_EQ(message_json.size(), consumed);
+	expect_message(parser.take());
+
+	EXPECT_EQ(stream.size() - consumed, parser.feed(stream.data() + consumed, stream.size() - consumed));
+	expect_message(parser.take());
+}
+
+TEST(INCREMENTAL_PARSER, ERRORS)
+{
+	Incremental_parser<Message> incomplete;
+	incomplete.feed(message_json.data(), message_json.size() / 2);
+	EXPECT_THROW(incomplete.take(), Bad_structure);
+
+	for (const auto json : {"[1]", "{\"id\":01}", "{\"id\":-}", "{\"id\":tru}", "{\"id\" 1}", "{\"id\":1,}",
+			"{\"id\":\"\\x\"}", "{\"id\":\"\\ud83d\"}", "{\"id\":[1}", "{\"id\":\"\x01\"}"})
+	{
+		Incremental_parser<Message> parser;
+		EXPECT_THROW(parser.feed(json), Bad_structure) << json;
+		EXPECT_THROW(parser.feed("{}"), Bad_structure);
+	}
+
+	Incremental_parser<Message> wrong_structure;
+	wrong_structure.feed("{\"id\":1}");
+	ASSERT_TRUE(wrong_structure.done());
+	EXPECT_THROW(wrong_structure.take(), Bad_structure);
+}
+
+TEST(INCREMENTAL_PARSER, LOCALE)
+{
+	const std::string previous = std::setlocale(LC_NUMERIC, nullptr);
+	const char* locale = nullptr;
+	for (const auto name : {"de_DE.UTF-8", "de_DE.utf8", "de_DE", "fr_FR.UTF-8", "it_IT.UTF-8", "German"})
+	{
+		if (std::setlocale(LC_NUMERIC, name))
+		{
+			locale = name;
+			break;
+		}
+	}
+	if (!locale)
+	{
+		GTEST_SKIP() << "No locale with a comma as decimal separator";
+	}
+
+	Incremental_parser<Message> parser;
+	parser.feed(message_json);
+	const auto message = parser.take();
+	std::setlocale(LC_NUMERIC, previous.c_str());
+	expect_message(message);
+}
@@ -0,0 +1,87 @@
+#include "gtest/gtest.h"
+#include "jsontype/Root.hpp"
+#include "jsontype/Inline_root.hpp"
+#include <string>
+#include <type_traits>
+
+using namespace jsontype;
+
+namespace
+{
+	JSONTYPE_MAKE_TAG(name);
+	JSONTYPE_MAKE_TAG(age);
+	JSONTYPE_MAKE_TAG(height);
+	JSONTYPE_MAKE_TAG(active);
+
+	using Person = Inline_root<Value_field<name_tag, std::string>,
+			Value_field<age_tag, unsigned>,
+			Value_field<height_tag, double>,
+			Value_field<active_tag, bool>>;
+	using Person_root = Root<Value_field<name_tag, std::string>,
+			Value_field<age_tag, unsigned>,
+			Value_field<height_tag, double>,
+			Value_field<active_tag, bool>>;
+
+	const std::string person_json("{\"name\":\"Paul\",\"age\":20,\"height\":1.5,\"active\":true}");
+}
+
+TEST(INLINE_ROOT, DEFAULT)
+{
+	const Person person;
+	EXPECT_EQ(Person_root().stringify(), person.stringify());
+	EXPECT_EQ("", person[name_tag{}].get());
+	EXPECT_EQ(0u, person[age_tag{}]);
+	EXPECT_FALSE(person[active_tag{}]);
+}
+
+TEST(INLINE_ROOT, PARSE)
+{
+	const Person person(person_json);
+	EXPECT_EQ("Paul", person[name_tag{}].get());
+	const std::string name = person.find(name_tag{});
+	EXPECT_EQ("Paul", name);
+	EXPECT_EQ(20u, person[age_tag{}]);
+	EXPECT_DOUBLE_EQ(1.5, person[height_tag{}]);
+	EXPECT_TRUE(person[active_tag{}]);
+	EXPECT_EQ(person_json, person.stringify());
+
+	const Person shuffled("{\"active\":false,\"age\":3,\"name\":\"Ann\",\"height\":2.5,\"id\":1}");
+	EXPECT_EQ("{\"name\":\"Ann\",\"age\":3,\"height\":2.5,\"active\":false}", shuffled.stringify());
+	EXPECT_FALSE(shuffled.document().HasMember("id"));
+	rapidjson::StringBuffer buffer;
+	rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+	shuffled.document().Accept(writer);
+	EXPECT_EQ(shuffled.stringify(), buffer.GetString());
+
+	EXPECT_THROW(Person("{\"name\":\"Paul\"}"), Bad_structure);
+	EXPECT_THROW(Person("{\"name\":\"Paul\",\"age\":\"old\",\"height\":1.5,\"active\":true}"), Bad_structure);
+}
+
+TEST(INLINE_ROOT, SET)
+{
+	Person person;
+	person[name_tag{}] = "Mario";
+	person[age_tag{}] = 30;
+	person.find(height_tag{}).set(1.75);
+	const unsigned age = person[age_tag{}];
+	EXPECT_EQ(30u, age);
+	EXPECT_EQ("Mario", person[name_tag{}].get());
+	EXPECT_EQ(Person(person.stringify()).stringify(), person.stringify());
+}
+
+TEST(INLINE_ROOT, DOCUMENT)
+{
+	Person person(person_json);
+	const auto& doc = person.document();
+	EXPECT_STREQ("Paul", doc["name"].GetString());
+	EXPECT_EQ(&doc, &person.ref());
+
+	person[name_tag{}] = "Mario";
+	EXPECT_STREQ("Mario", person.document()["name"].GetString());
+	EXPECT_EQ(20u, person.ref()["age"].GetUint());
+	EXPECT_EQ(person.stringify(), Person_root(person.stringify()).stringify());
+
+	Person moved(std::move(person));
+	EXPECT_EQ("Mario", moved[name_tag{}].get());
+	EXPECT_STREQ("Mario", moved.document()["name"].GetString());
+}
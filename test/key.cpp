@@ -63,3 +63,14 @@ TEST(KEY, OBJECT_COMPOSITION)
 		EXPECT_EQ(true, same);
 	}
 }
+
+TEST(KEY, TAG_METADATA)
+{
+	static_assert(size_tag::length() == 4, "Tag length must be known at compile time");
+	static_assert(version_tag::length() == 7, "Tag length must be known at compile time");
+	static_assert(size_tag::hash() != color_tag::hash(), "Tag hash must be known at compile time");
+
+	const std::string color("color");
+	EXPECT_EQ(color_tag::hash(), detail::string_hash(color.data(), color.size()));
+	EXPECT_NE(color_tag::hash(), detail::string_hash(color.data(), color.size() - 1));
+}
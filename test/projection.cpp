@@ -0,0 +1,52 @@
+#include "gtest/gtest.h"
+#include "jsontype/Root.hpp"
+#include "jsontype/Projection.hpp"
+#include <string>
+
+using namespace jsontype;
+
+namespace
+{
+	JSONTYPE_MAKE_TAG(id);
+	JSONTYPE_MAKE_TAG(name);
+	JSONTYPE_MAKE_TAG(contact);
+	JSONTYPE_MAKE_TAG(address);
+	JSONTYPE_MAKE_TAG(phones);
+
+	using Person = Root<Value_field<id_tag, unsigned>,
+			Value_field<name_tag, std::string>,
+			Object<contact_tag, Value_field<address_tag, std::string>, Array<phones_tag>>>;
+
+	const std::string person_json("{\"history\":[{\"x\":\"]}\\\"{\"},[1,2,[3]],{}], \"id\" : 7,"
+			"\"contact\":{\"notes\":\"a \\\\\\\" b\",\"address\":\"74 Green St\",\"extra\":{\"phones\":1},"
+			"\"phones\":[\"123\",\"456\"]},\"score\":-1.5e3,\"active\":true,\"na\\u006de\":\"Paul\",\"tail\":null}");
+}
+
+TEST(PROJECTION, DECLARED_MEMBERS)
+{
+	const auto person = project<Person>(person_json);
+	EXPECT_EQ(7u, person[id_tag{}].get());
+	EXPECT_EQ("Paul", person[name_tag{}].get());
+	EXPECT_EQ("74 Green St", person[contact_tag{}][address_tag{}].get());
+	EXPECT_EQ(3u, person.ref().MemberCount());
+	EXPECT_EQ(2u, person.ref()["contact"].MemberCount());
+	EXPECT_EQ(2u, person.ref()["contact"]["phones"].Size());
+
+	EXPECT_EQ(Person(person_json), person);
+	EXPECT_EQ(person.stringify(), project<Person>(person.stringify()).stringify());
+}
+
+TEST(PROJECTION, ERRORS)
+{
+	EXPECT_THROW(project<Person>(std::string("")), Bad_structure);
+	EXPECT_THROW(project<Person>(std::string("[]")), Bad_structure);
+	EXPECT_THROW(project<Person>(std::string("{\"id\":1,\"name\":\"a\",\"contact\":{\"address\":\"b\",\"phones\":[]}")),
+			Bad_structure);
+	EXPECT_THROW(project<Person>(std::string("{\"x\":\"unterminated, \"id\":1}")), Bad_structure);
+	EXPECT_THROW(project<Person>(std::string("{\"x\":{\"y\":[}}")), Bad_structure);
+	EXPECT_THROW(project<Person>(std::string("{\"id\":1,\"name\":\"a\"}")), Bad_structure);
+	EXPECT_THROW(project<Person>(std::string("{\"id\":\"1\",\"name\":\"a\",\"contact\":{\"address\":\"b\",\"phones\":[]}}")),
+			Bad_structure);
+	EXPECT_THROW(project<Person>(std::string("{\"id\":1,\"name\":\"a\",\"contact\":[]}")), Bad_structure);
+	EXPECT_NO_THROW(project<Person>(std::string(" {\"id\":1,\"name\":\"a\",\"contact\":{\"address\":\"b\",\"phones\":[]}} ")));
+}
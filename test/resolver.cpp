@@ -94,5 +94,109 @@ TEST(RESOLVER, FUNC_ARGS)
 
 	const auto res = resolver.scan("{\"name_0\":{\"name_1\":0}}", 4);
 	EXPECT_EQ(8, res);
+	EXPECT_EQ(6, resolver.invoke(key_01{}, 3));
 }
 
+
+TEST(RESOLVER, TYPED)
+{
+	using Small = Root<Object<name_0_tag, Value_field<name_1_tag, int>>>;
+	using Large = Root<Object<name_0_tag, Value_field<name_1_tag, int>, Value_field<name_2_tag, int>>>;
+	using key_02 = Key<name_0_tag, name_2_tag>;
+
+	Typed_resolver<int(int)> resolver;
+	resolver.add<Small>(key_01{}, [](Small small, int factor) { return small[key_01{}] * factor; });
+	resolver.add<Large>(key_02{}, [](Large&& large, int factor) { return large[key_02{}] * factor; });
+
+	EXPECT_EQ(6, resolver.scan("{\"name_0\":{\"name_1\":3}}", 2));
+	EXPECT_EQ(10, resolver.scan("{\"name_0\":{\"name_2\":5,\"name_1\":3}}", 2));
+
+	rapidjson::Document doc;
+	doc.Parse("{\"name_0\":{\"name_1\":4}}");
+	EXPECT_EQ(4, resolver.scan(std::move(doc), 1));
+
+	EXPECT_THROW(resolver.scan("{\"name_0\":{\"name_2\":5}}", 2), Bad_structure);
+	EXPECT_THROW(resolver.scan("{\"name_3\":{}}", 2), std::out_of_range);
+	EXPECT_THROW(resolver.scan("[]", 2), std::runtime_error);
+}
+
+TEST(RESOLVER, VALUE_MATCH)
+{
+	JSONTYPE_MAKE_TAG(type);
+	JSONTYPE_MAKE_TAG(order_created);
+	JSONTYPE_MAKE_TAG(order_deleted);
+	JSONTYPE_MAKE_TAG(version);
+	JSONTYPE_MAKE_TAG(code);
+
+	using created = Key<Value_match<type_tag, order_created_tag>>;
+	using created_v2 = Key<Value_match<type_tag, order_created_tag>, Int_match<version_tag, 2>>;
+	using deleted = Key<Value_match<type_tag, order_deleted_tag>>;
+	using nested_code = Key<name_0_tag, Int_match<code_tag, -7>>;
+
+	Resolver<std::function<int()>> resolver;
+	resolver.add(created{}, []{ return 1; });
+	resolver.add(created_v2{}, []{ return 2; });
+	resolver.add(deleted{}, []{ return 3; });
+	resolver.add(nested_code{}, []{ return 4; });
+	resolver.add(key_3{}, []{ return 5; });
+
+	EXPECT_EQ(1, resolver.scan("{\"id\":1,\"type\":\"order_created\"}"));
+	EXPECT_EQ(2, resolver.scan("{\"type\":\"order_created\",\"version\":2}"));
+	EXPECT_EQ(2, resolver.scan("{\"version\":2,\"type\":\"order_created\"}"));
+	EXPECT_EQ(1, resolver.scan("{\"type\":\"order_created\",\"version\":3}"));
+	EXPECT_EQ(3, resolver.scan("{\"type\":\"order_deleted\"}"));
+	EXPECT_EQ(4, resolver.scan("{\"name_0\":{\"code\":-7}}"));
+	EXPECT_EQ(5, resolver.scan("{\"type\":\"order_updated\",\"name_3\":{}}"));
+	EXPECT_THROW(resolver.scan("{\"type\":\"order_updated\"}"), std::out_of_range);
+	EXPECT_THROW(resolver.scan("{\"type\":1}"), std::out_of_range);
+	EXPECT_THROW(resolver.scan("{\"name_0\":{\"code\":7}}"), std::out_of_range);
+
+	EXPECT_EQ(2, resolver.invoke(created_v2{}));
+	EXPECT_EQ(4, resolver.invoke(nested_code{}));
+	EXPECT_THROW(resolver.invoke(Key<Value_match<type_tag, version_tag>>{}), std::out_of_range);
+}
+
+TEST(RESOLVER, HANDLE)
+{
+	Resolver<std::function<int(int)>> resolver;
+	resolver.add(key_01{}, [](int i) { return i + 1; });
+
+	const auto handle = resolver.handle(key_01{});
+	EXPECT_EQ(3, handle(2));
+
+	for (int i = 0; i < 100; ++i)
+	{
+		resolver.add(Key<name_4_tag>{} + Key<name_1_tag>{}, [i](int) { return i; });
+		resolver.add(key_012{}, [](int i) { return i; });
+	}
+	EXPECT_EQ(3, handle(2));
+
+	resolver.add(key_01{}, [](int i) { return i * 10; });
+	EXPECT_EQ(20, handle(2));
+
+	EXPECT_THROW(resolver.handle(key_3{}), std::out_of_range);
+	EXPECT_THROW(resolver.handle(Key<name_0_tag>{}), std::out_of_range);
+}
+
+TEST(RESOLVER, MEMORY_USAGE)
+{
+	JSONTYPE_MAKE_TAG(type);
+
+	Resolver<std::function<int()>> resolver;
+	const auto empty = resolver.memory_usage();
+	EXPECT_EQ(1u, empty.nodes);
+
+	resolver.add(key_01{}, []{ return 1; });
+	resolver.add(key_012{}, []{ return 2; });
+	const auto keys = resolver.memory_usage();
+	EXPECT_EQ(4u, keys.nodes);
+	EXPECT_GT(keys.bytes, empty.bytes);
+
+	resolver.add(Key<Value_match<type_tag, name_3_tag>>{}, []{ return 3; });
+	const auto values = resolver.memory_usage();
+	EXPECT_EQ(5u, values.nodes);
+	EXPECT_GT(values.bytes, keys.bytes);
+
+	resolver.add(key_01{}, []{ return 4; });
+	EXPECT_EQ(values.nodes, resolver.memory_usage().nodes);
+}
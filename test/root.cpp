@@ -4,6 +4,11 @@
 #include <cstdint>
 #include <iostream>
 #include <utility>
+#include <fstream>
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include <functional>
 
 using namespace jsontype;
 
@@ -14,6 +19,9 @@ namespace
 	JSONTYPE_MAKE_TAG(state);
 	JSONTYPE_MAKE_TAG(capital);
 	JSONTYPE_MAKE_TAG(time);
+	JSONTYPE_MAKE_TAG(stops);
+	JSONTYPE_MAKE_TAG(trip);
+	JSONTYPE_MAKE_TAG(trips);
 
 	using City = Object<city_tag,
 			Value_field<name_tag, std::string>,
@@ -157,6 +165,9 @@ TEST(ROOT, ARRAY)
  	const std::string json_str = json.stringify();
  	const std::string json_expected("{\"value\":0,\"node\":{\"array\":[]}}");
  	EXPECT_EQ(json_expected, json_str);
+ 	EXPECT_EQ(0u, json[value_tag{}].get());
+ 	using array_key = Key<node_tag, array_tag>;
+ 	EXPECT_EQ("[]", json[array_key{}].stringify());
 }
 
 TEST(ROOT, VALUE_TYPES)
@@ -199,3 +210,414 @@ TEST(ROOT, VALUE_TYPES)
 	cstring_v[Val{}] = "blobloblo";
 	EXPECT_STREQ("blobloblo", cstring_v[Val{}].get());
 }
+
+TEST(ROOT, TRACKED)
+{
+	using namespace std::string_literals;
+	using Tracked_travel = Tracked_root<City, Value_field<time_tag, int>>;
+
+	Tracked_travel tracked;
+	Travel plain;
+	EXPECT_EQ(plain.stringify(), tracked.stringify());
+
+	tracked[time_tag{}] = 7;
+	plain[time_tag{}] = 7;
+	EXPECT_EQ(plain.stringify(), tracked.stringify());
+
+	tracked[city_tag{}][name_tag{}] = "Paris";
+	plain[city_tag{}][name_tag{}] = "Paris";
+	EXPECT_EQ(plain.stringify(), tracked.stringify());
+	EXPECT_EQ(plain.stringify(), tracked.stringify());
+
+	using key = Key<city_tag, capital_tag>;
+	tracked[key{}] = true;
+	plain[key{}] = true;
+	EXPECT_EQ(plain.stringify(), tracked.stringify());
+
+	{
+		Tracked_travel parsed("{\"city\":{\"name\":\"Rome\",\"state\":\"Italy\",\"capital\":true},\"extra\":[1],\"time\":2}"s);
+		EXPECT_EQ("{\"city\":{\"name\":\"Rome\",\"state\":\"Italy\",\"capital\":true},\"extra\":[1],\"time\":2}"s,
+				parsed.stringify());
+		parsed[city_tag{}][state_tag{}] = "Lazio";
+		EXPECT_EQ("{\"city\":{\"name\":\"Rome\",\"state\":\"Lazio\",\"capital\":true},\"extra\":[1],\"time\":2}"s,
+				parsed.stringify());
+	}
+}
+
+TEST(ROOT, STRINGIFY_TO)
+{
+	const std::string json("{\"city\":{\"name\":\"\",\"state\":\"\",\"capital\":false},\"time\":0}");
+	const Travel travel;
+
+	rapidjson::StringBuffer buffer;
+	travel.stringify_to(buffer);
+	EXPECT_EQ(json, buffer.GetString());
+
+	char data[128];
+	EXPECT_EQ(json.size(), travel.stringify_to(data, sizeof(data)));
+	EXPECT_EQ(json, std::string(data, json.size()));
+
+	char small[8];
+	EXPECT_EQ(json.size(), travel.stringify_to(small, sizeof(small)));
+	EXPECT_EQ(json.substr(0, sizeof(small)), std::string(small, sizeof(small)));
+
+	const std::string city("{\"name\":\"\",\"state\":\"\",\"capital\":false}");
+	EXPECT_EQ(city.size(), travel[city_tag{}].stringify_to(data, sizeof(data)));
+	EXPECT_EQ(city, std::string(data, city.size()));
+
+	Tracked_root<City, Value_field<time_tag, int>> tracked;
+	tracked[time_tag{}] = 3;
+	buffer.Clear();
+	tracked.stringify_to(buffer);
+	EXPECT_EQ(tracked.stringify(), buffer.GetString());
+}
+
+#ifdef JSONTYPE_HAS_FD_STREAM
+TEST(ROOT, FD_STREAM)
+{
+	using city_name = Key<city_tag, name_tag>;
+
+	// Longer than the stream's buffer, so it's written in more than one piece
+	Travel long_travel;
+	long_travel[city_name{}] = std::string(10000, 'x');
+	const auto json = long_travel.stringify();
+
+	int fds[2];
+	ASSERT_EQ(0, ::pipe(fds));
+	{
+		Fd_output_stream os(fds[1]);
+		long_travel.stringify_to(os);
+	}
+	::close(fds[1]);
+	std::string written;
+	char data[1024];
+	for (ssize_t n; (n = ::read(fds[0], data, sizeof(data))) > 0;)
+	{
+		written.append(data, static_cast<std::size_t>(n));
+	}
+	::close(fds[0]);
+	EXPECT_EQ(json, written);
+	EXPECT_NO_THROW(Travel{written});
+
+	Fd_output_stream closed(fds[1]);
+	EXPECT_THROW(travel.stringify_to(closed), std::system_error);
+}
+#endif
+
+TEST(ROOT, FROM_FILE)
+{
+	const std::string path("jsontype_from_file_test.json");
+	const std::string json("{\"city\":{\"name\":\"Rome\",\"state\":\"Italy\",\"capital\":true},\"time\":2}");
+	std::ofstream(path) << json;
+
+	const auto t = Travel::from_file(path);
+	EXPECT_EQ(json, t.stringify());
+	EXPECT_EQ(2, t[time_tag{}]);
+
+	std::ofstream(path) << "{\"time\":2}";
+	EXPECT_THROW(Travel::from_file(path), Bad_structure);
+	std::remove(path.c_str());
+
+	EXPECT_ANY_THROW(Travel::from_file(path));
+}
+
+TEST(ROOT, CLONE)
+{
+	Travel original;
+	original[time_tag{}] = 5;
+	auto copy = original.clone();
+	EXPECT_EQ(original.stringify(), copy.stringify());
+
+	copy[time_tag{}] = 6;
+	copy[Key<city_tag>{} + name_tag{}] = "Milan";
+	EXPECT_EQ(5, original[time_tag{}]);
+	EXPECT_EQ(6, copy[time_tag{}]);
+	EXPECT_EQ("", original[Key<city_tag>{} + name_tag{}].get());
+
+	Tracked_root<City> tracked;
+	tracked.stringify();
+	auto tracked_copy = tracked.clone();
+	tracked_copy[Key<city_tag>{} + state_tag{}] = "Italy";
+	EXPECT_EQ("{\"city\":{\"name\":\"\",\"state\":\"Italy\",\"capital\":false}}", tracked_copy.stringify());
+	EXPECT_NE(tracked.stringify(), tracked_copy.stringify());
+}
+
+TEST(ROOT, CANONICAL)
+{
+	using city_name = Key<city_tag, name_tag>;
+	using city_capital = Key<city_tag, capital_tag>;
+
+	EXPECT_TRUE(travel.canonical());
+	EXPECT_TRUE(Travel(travel.stringify()).canonical());
+
+	const Travel shuffled("{\"time\":3,\"city\":{\"capital\":false,\"name\":\"Turin\",\"state\":\"Italy\"}}");
+	EXPECT_FALSE(shuffled.canonical());
+	EXPECT_EQ(3, shuffled[time_tag{}]);
+	EXPECT_EQ("Turin", shuffled[city_name{}].get());
+	EXPECT_FALSE(shuffled[city_capital{}]);
+
+	const Travel nested_shuffled("{\"city\":{\"state\":\"Italy\",\"name\":\"Rome\",\"capital\":true},\"time\":2}");
+	EXPECT_FALSE(nested_shuffled.canonical());
+	EXPECT_EQ("Rome", nested_shuffled[city_name{}].get());
+
+	const Travel extra_members("{\"city\":{\"name\":\"Rome\",\"state\":\"Italy\",\"capital\":true},\"time\":2,\"id\":7}");
+	EXPECT_TRUE(extra_members.canonical());
+}
+
+TEST(ROOT, HASH_EQUALITY)
+{
+	using city_key = Key<city_tag>;
+
+	const Travel first("{\"city\":{\"name\":\"Rome\",\"state\":\"Italy\",\"capital\":true},\"time\":2}");
+	const Travel shuffled("{\"time\":2,\"id\":7,\"city\":{\"capital\":true,\"state\":\"Italy\",\"name\":\"Rome\"}}");
+	const Tracked_root<City, Value_field<time_tag, int>> tracked(first.stringify());
+	EXPECT_TRUE(first == shuffled);
+	EXPECT_TRUE(first == tracked);
+	EXPECT_EQ(hash(first), hash(shuffled));
+	EXPECT_EQ(std::hash<Travel>()(first), hash(shuffled));
+	EXPECT_TRUE(first[city_key{}] == shuffled[city_key{}]);
+	EXPECT_EQ(hash(first[city_key{}]), hash(shuffled[city_key{}]));
+
+	const Travel other_time("{\"city\":{\"name\":\"Rome\",\"state\":\"Italy\",\"capital\":true},\"time\":3}");
+	const Travel other_city("{\"city\":{\"name\":\"Milan\",\"state\":\"Italy\",\"capital\":false},\"time\":2}");
+	EXPECT_TRUE(first != other_time);
+	EXPECT_TRUE(first != other_city);
+	EXPECT_NE(hash(first), hash(other_time));
+	EXPECT_NE(hash(first), hash(other_city));
+	EXPECT_TRUE(first[city_key{}] == other_time[city_key{}]);
+	EXPECT_TRUE(first[city_key{}] != other_city[city_key{}]);
+}
+
+TEST(ROOT, TYPED_ARRAY_HASH_EQUALITY)
+{
+	using Trip = Root<Array<stops_tag, City>>;
+
+	const Trip first("{\"stops\":[{\"name\":\"Rome\",\"state\":\"Italy\",\"capital\":true}]}");
+	const Trip extra_member("{\"stops\":[{\"capital\":true,\"name\":\"Rome\",\"state\":\"Italy\",\"id\":7}]}");
+	EXPECT_TRUE(first == extra_member);
+	EXPECT_EQ(hash(first), hash(extra_member));
+
+	const Trip other_stop("{\"stops\":[{\"name\":\"Milan\",\"state\":\"Italy\",\"capital\":false}]}");
+	const Trip more_stops("{\"stops\":[{\"name\":\"Rome\",\"state\":\"Italy\",\"capital\":true},"
+			"{\"name\":\"Rome\",\"state\":\"Italy\",\"capital\":true}]}");
+	EXPECT_TRUE(first != other_stop);
+	EXPECT_TRUE(first != more_stops);
+	EXPECT_NE(hash(first), hash(other_stop));
+	EXPECT_NE(hash(first), hash(more_stops));
+}
+
+TEST(ROOT, DEFAULT_FROM_PROTOTYPE)
+{
+	using city_name = Key<city_tag, name_tag>;
+
+	Travel first;
+	first[city_name{}] = "Paris";
+	first[time_tag{}] = 9;
+	const Travel second;
+	EXPECT_EQ("", second[city_name{}].get());
+	EXPECT_EQ(0, second[time_tag{}]);
+	EXPECT_EQ("{\"city\":{\"name\":\"\",\"state\":\"\",\"capital\":false},\"time\":0}", second.stringify());
+	EXPECT_TRUE(second.canonical());
+
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; ++t)
+	{
+		threads.emplace_back([]
+		{
+			for (int i = 0; i < 100; ++i)
+			{
+				Tracked_root<City> tracked;
+				tracked[city_name{}] = "Rome";
+				EXPECT_EQ("{\"city\":{\"name\":\"Rome\",\"state\":\"\",\"capital\":false}}", tracked.stringify());
+			}
+		});
+	}
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+}
+
+TEST(ROOT, COMPACT)
+{
+	using city_name = Key<city_tag, name_tag>;
+	const std::string long_name(200, 'x');
+
+	Travel travel_copy(travel.stringify());
+	for (int i = 0; i < 1000; ++i)
+	{
+		travel_copy[city_name{}] = long_name + std::to_string(i);
+	}
+	const auto before = travel_copy.memory_usage();
+	EXPECT_LE(before.used, before.reserved);
+	EXPECT_LT(before.live * 100, before.used);
+	EXPECT_EQ(before.used - before.live, before.lost);
+
+	travel_copy.compact();
+	const auto after = travel_copy.memory_usage();
+	EXPECT_EQ(before.live, after.used);
+	EXPECT_EQ(after.live, after.used);
+	EXPECT_EQ(0u, after.lost);
+	EXPECT_LT(after.reserved, before.reserved);
+	EXPECT_EQ(long_name + "999", travel_copy[city_name{}].get());
+	EXPECT_EQ(travel[time_tag{}].get(), travel_copy[time_tag{}].get());
+
+	Tracked_root<City> tracked;
+	tracked[city_name{}] = long_name;
+	tracked.stringify();
+	tracked.compact();
+	tracked[Key<city_tag, state_tag>{}] = "Italy";
+	EXPECT_EQ("{\"city\":{\"name\":\"" + long_name + "\",\"state\":\"Italy\",\"capital\":false}}", tracked.stringify());
+}
+
+TEST(ROOT, MEMORY_COUNTERS)
+{
+	using Counted_travel = Counted_root<City, Value_field<time_tag, int>>;
+
+	const auto& counters = Counted_travel::memory_counters();
+	EXPECT_EQ(0u, counters.created);
+	EXPECT_EQ(0u, counters.alive);
+	EXPECT_EQ(0u, counters.reserved);
+	{
+		Counted_travel first("{\"city\":{\"name\":\"Rome\",\"state\":\"Italy\",\"capital\":true},\"time\":2}");
+		EXPECT_EQ(1u, counters.created);
+		EXPECT_EQ(1u, counters.alive);
+		EXPECT_EQ(first.memory_usage().reserved, counters.reserved);
+
+		const auto copy = first.clone();
+		EXPECT_EQ(2u, counters.created);
+		EXPECT_EQ(2u, counters.alive);
+		EXPECT_LT(first.memory_usage().reserved, counters.reserved);
+
+		// A moved from root is still destroyed, so moving counts as a new live root but not as a creation
+		Counted_travel moved(std::move(first));
+		EXPECT_EQ(2u, counters.created);
+		EXPECT_EQ(3u, counters.alive);
+
+		Counted_travel defaulted;
+		defaulted = std::move(moved);
+		EXPECT_EQ(3u, counters.created);
+		EXPECT_EQ(4u, counters.alive);
+		EXPECT_EQ(2, defaulted[time_tag{}].get());
+	}
+	EXPECT_EQ(3u, counters.created);
+	EXPECT_EQ(0u, counters.alive);
+	EXPECT_LT(0u, counters.reserved);
+
+	const Travel uncounted;
+	EXPECT_EQ(0u, Travel::memory_counters().created);
+	EXPECT_EQ(0u, Travel::memory_counters().alive);
+}
+
+TEST(ROOT, PHASE_STATISTICS)
+{
+	using Timed_travel = Timed_root<City, Value_field<time_tag, int>>;
+	using city_name = Key<city_tag, name_tag>;
+
+	auto work = []
+	{
+		Timed_travel timed(travel.stringify());
+		timed[city_name{}] = "Rome";
+		timed[time_tag{}] = 3;
+		const auto& const_timed = timed;
+		EXPECT_EQ(3, const_timed[time_tag{}].get());
+		timed.stringify();
+	};
+	work();
+	std::thread worker(work);
+	worker.join();
+
+	const auto statistics = Timed_travel::phase_statistics();
+	EXPECT_EQ(2u, statistics[Root_phase::parse].calls);
+	EXPECT_EQ(2u, statistics[Root_phase::structure_check].calls);
+	EXPECT_EQ(6u, statistics[Root_phase::find].calls);
+	EXPECT_EQ(4u, statistics[Root_phase::set].calls);
+	EXPECT_EQ(2u, statistics[Root_phase::stringify].calls);
+	EXPECT_GT(statistics[Root_phase::parse].cycles, 0u);
+
+	EXPECT_EQ(0u, Travel::phase_statistics()[Root_phase::find].calls);
+}
+
+TEST(ROOT, TYPED_ARRAY)
+{
+	using Trip = Root<Array<stops_tag, City>>;
+
+	Trip trip("{\"stops\":[{\"name\":\"Rome\",\"state\":\"Italy\",\"capital\":true},"
+			"{\"name\":\"Lyon\",\"state\":\"France\",\"capital\":false}]}");
+	EXPECT_EQ(2u, trip[stops_tag{}].size());
+	EXPECT_EQ("Lyon", trip[stops_tag{}][1][name_tag{}].get());
+	trip[stops_tag{}][1][state_tag{}] = "Francia";
+	const auto& const_trip = trip;
+	EXPECT_EQ("Francia", const_trip[stops_tag{}][1].find(state_tag{}).get());
+	const auto stops = trip[stops_tag{}];
+	EXPECT_EQ("Francia", stops[1][state_tag{}].get());
+	const auto const_stops = const_trip[stops_tag{}];
+	EXPECT_EQ("Rome", const_stops[0][name_tag{}].get());
+	EXPECT_TRUE(trip.canonical());
+	EXPECT_EQ(0u, Trip()[stops_tag{}].size());
+
+	auto error = [](const std::string& json) -> std::string
+	{
+		try
+		{
+			Trip bad(json);
+		}
+		catch (const Bad_structure& e)
+		{
+			return e.what();
+		}
+		return "";
+	};
+	EXPECT_EQ("Element 1 of stops: Missing value member: state",
+			error("{\"stops\":[{\"name\":\"\",\"state\":\"\",\"capital\":true},{\"name\":\"\",\"capital\":true}]}"));
+	EXPECT_EQ("Element 0 of stops: city is not an object", error("{\"stops\":[3]}"));
+
+	// Large enough to be checked in chunks, the first bad element is reported whichever chunk finds it first
+	const std::string element = "{\"name\":\"Rome\",\"state\":\"Italy\",\"capital\":true}";
+	std::string many = "{\"stops\":[";
+	for (int i = 0; i < 50000; ++i)
+	{
+		many += i == 0 ? "" : ",";
+		many += i == 31000 || i == 45000 ? "{\"name\":1}" : element;
+	}
+	many += "]}";
+	EXPECT_EQ("Element 31000 of stops: Value of name is of the wrong type", error(many));
+
+	// Arrays within the elements of a split array are checked in one piece by the thread checking the element
+	std::vector<std::size_t> counts;
+	set_check_executor([&](std::size_t count, const std::function<void(std::size_t)>& chunk)
+	{
+		counts.push_back(count);
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			chunk(i);
+		}
+	});
+	using Tour = Root<Array<trips_tag, Object<trip_tag, Array<stops_tag, City>>>>;
+	std::string tour = "{\"trips\":[";
+	for (int i = 0; i < 10000; ++i)
+	{
+		tour += i == 0 ? "" : ",";
+		tour += i == 9000 ? many : "{\"stops\":[]}";
+	}
+	tour += "]}";
+	try
+	{
+		Tour bad(tour);
+		ADD_FAILURE();
+	}
+	catch (const Bad_structure& e)
+	{
+		EXPECT_STREQ("Element 9000 of trips: Element 31000 of stops: Value of name is of the wrong type", e.what());
+	}
+	EXPECT_EQ(std::vector<std::size_t>{2}, counts);
+	EXPECT_EQ("Element 31000 of stops: Value of name is of the wrong type", error(many));
+	EXPECT_EQ((std::vector<std::size_t>{2, 7}), counts);
+	set_check_executor(nullptr);
+
+	Tracked_root<Array<stops_tag, City>> tracked(trip.stringify());
+	tracked.stringify();
+	tracked[stops_tag{}][0][name_tag{}] = "Roma";
+	EXPECT_EQ("{\"stops\":[{\"name\":\"Roma\",\"state\":\"Italy\",\"capital\":true},"
+			"{\"name\":\"Lyon\",\"state\":\"Francia\",\"capital\":false}]}", tracked.stringify());
+}
@@ -0,0 +1,64 @@
+#include "gtest/gtest.h"
+#include "jsontype/Root.hpp"
+#include "jsontype/Root_batch.hpp"
+#include <string>
+#include <stdexcept>
+
+using namespace jsontype;
+
+namespace
+{
+	JSONTYPE_MAKE_TAG(id);
+	JSONTYPE_MAKE_TAG(position);
+	JSONTYPE_MAKE_TAG(x);
+	JSONTYPE_MAKE_TAG(y);
+
+	using Point = Object<position_tag, Value_field<x_tag, int>, Value_field<y_tag, int>>;
+	using Records = Root_batch<Value_field<id_tag, unsigned>, Point>;
+	using Record = Root<Value_field<id_tag, unsigned>, Point>;
+	using position_x = Key<position_tag, x_tag>;
+
+	const std::string records_json("[{\"id\":1,\"position\":{\"x\":10,\"y\":20}},"
+			"{\"position\":{\"y\":40,\"x\":30},\"id\":2,\"note\":\"extra\"}]");
+}
+
+TEST(ROOT_BATCH, PARSE)
+{
+	const Records records(records_json);
+	ASSERT_EQ(2u, records.size());
+	EXPECT_EQ(1u, records[0][id_tag{}].get());
+	EXPECT_EQ(30, records[1][position_x{}].get());
+	EXPECT_EQ(records_json, records.stringify());
+	EXPECT_THROW(records.at(2), std::out_of_range);
+
+	EXPECT_TRUE(Records("[]").empty());
+	EXPECT_THROW(Records("{\"id\":1}"), Bad_structure);
+	EXPECT_THROW(Records("[{\"id\":1,\"position\":{\"x\":10,\"y\":20}},{\"id\":2}]"), Bad_structure);
+	EXPECT_THROW(Records("[{\"id\":1,\"position\":{\"x\":10,\"y\":20}},3]"), Bad_structure);
+}
+
+TEST(ROOT_BATCH, PUSH_BACK)
+{
+	Records records;
+	for (unsigned i = 0; i < 100; ++i)
+	{
+		Record record;
+		record[id_tag{}] = i;
+		records.push_back(record.stringify());
+	}
+	ASSERT_EQ(100u, records.size());
+	EXPECT_EQ(57u, records.at(57)[id_tag{}].get());
+	EXPECT_THROW(records.push_back("{\"id\":1}"), Bad_structure);
+	EXPECT_THROW(records.push_back("{\"id\""), Bad_structure);
+	EXPECT_EQ(100u, records.size());
+}
+
+TEST(ROOT_BATCH, MANIPULATION)
+{
+	Records records(records_json);
+	records[0][position_x{}] = -1;
+	records.at(1)[id_tag{}] = 7u;
+	EXPECT_EQ(-1, records[0][position_x{}].get());
+	EXPECT_EQ(7u, records[1][id_tag{}].get());
+	EXPECT_EQ("{\"id\":1,\"position\":{\"x\":-1,\"y\":20}}", records[0].stringify());
+}
@@ -0,0 +1,93 @@
+#include "gtest/gtest.h"
+#include "jsontype/Root.hpp"
+#include "jsontype/Snapshot.hpp"
+#include <string>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace jsontype;
+
+namespace
+{
+	JSONTYPE_MAKE_TAG(server);
+	JSONTYPE_MAKE_TAG(port);
+	JSONTYPE_MAKE_TAG(backup_port);
+	JSONTYPE_MAKE_TAG(version);
+
+	using Config = Root<Object<server_tag, Value_field<port_tag, int>, Value_field<backup_port_tag, int>>,
+			Value_field<version_tag, int>>;
+	using server_port = Key<server_tag, port_tag>;
+	using server_backup_port = Key<server_tag, backup_port_tag>;
+
+	Config make_config(int version)
+	{
+		Config config;
+		config[version_tag{}] = version;
+		config[server_port{}] = version;
+		config[server_backup_port{}] = version + 1;
+		return config;
+	}
+}
+
+TEST(SNAPSHOT, FREEZE)
+{
+	const auto snapshot = freeze(make_config(4));
+	EXPECT_EQ(4, snapshot[version_tag{}]);
+	EXPECT_EQ(5, snapshot[server_backup_port{}].get());
+	EXPECT_EQ(make_config(4).stringify(), snapshot.stringify());
+
+	const auto copy = snapshot;
+	EXPECT_EQ(&*snapshot, &*copy);
+}
+
+TEST(SNAPSHOT, HOLDER)
+{
+	Snapshot_holder<Config> holder(freeze(make_config(0)));
+	const auto first = holder.load();
+
+	holder.store(freeze(make_config(1)));
+	EXPECT_EQ(1, holder.load()[version_tag{}]);
+	EXPECT_EQ(0, first[version_tag{}]);
+}
+
+TEST(SNAPSHOT, CONCURRENT_RELOAD)
+{
+	const int versions = 200;
+	Snapshot_holder<Config> holder(freeze(make_config(0)));
+	std::atomic<bool> done{false};
+	std::atomic<int> torn{0};
+
+	std::vector<std::thread> readers;
+	for (int i = 0; i < 4; ++i)
+	{
+		readers.emplace_back([&]
+		{
+			int last_version = 0;
+			while (!done)
+			{
+				const auto snapshot = holder.load();
+				const int version = snapshot[version_tag{}];
+				if (version < last_version
+						|| snapshot[server_port{}].get() != version
+						|| snapshot[server_backup_port{}].get() != version + 1)
+				{
+					++torn;
+				}
+				last_version = version;
+			}
+		});
+	}
+	for (int version = 1; version <= versions; ++version)
+	{
+		holder.store(freeze(make_config(version)));
+	}
+	done = true;
+	for (auto& reader : readers)
+	{
+		reader.join();
+	}
+
+	EXPECT_EQ(0, torn);
+	EXPECT_EQ(versions, holder.load()[version_tag{}]);
+}
@@ -0,0 +1,172 @@
+#include "gtest/gtest.h"
+#include "jsontype/Root.hpp"
+#include "jsontype/String_pool.hpp"
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace jsontype;
+
+namespace
+{
+	JSONTYPE_MAKE_TAG(country);
+	JSONTYPE_MAKE_TAG(device);
+	JSONTYPE_MAKE_TAG(model);
+	JSONTYPE_MAKE_TAG(count);
+	JSONTYPE_MAKE_TAG(records);
+	JSONTYPE_MAKE_TAG(label);
+
+	using Device = Object<device_tag, Value_field<model_tag, std::string>>;
+	using Session = Interned_root<Value_field<country_tag, std::string>, Device, Value_field<count_tag, int>>;
+	using model_key = Key<device_tag, model_tag>;
+
+	const std::string session_json("{\"country\":\"United Kingdom of Great Britain\","
+			"\"device\":{\"model\":\"Pixel 7 Pro Max Ultra Edition\"},\"count\":1}");
+	const auto& pool = String_pool<char>::shared();
+}
+
+TEST(STRING_POOL, INTERN)
+{
+	String_pool<char> local_pool;
+	const auto first = local_pool.intern("abc", 3);
+	const auto second = local_pool.intern("abcdef", 3);
+	EXPECT_EQ(first, second);
+	EXPECT_EQ("abc", *first);
+	EXPECT_NE(first, local_pool.intern("abcdef", 6));
+	EXPECT_EQ(2u, local_pool.size());
+	EXPECT_EQ(1u, local_pool.release_unused());
+	EXPECT_EQ(1u, local_pool.size());
+}
+
+TEST(STRING_POOL, SHARED_VALUES)
+{
+	const Session first(session_json);
+	const Session second(session_json);
+	EXPECT_EQ("United Kingdom of Great Britain", first[country_tag{}].get());
+	EXPECT_EQ("Pixel 7 Pro Max Ultra Edition", second[model_key{}].get());
+	EXPECT_EQ(first.ref()["country"].GetString(), second.ref()["country"].GetString());
+	EXPECT_EQ(first.ref()["device"]["model"].GetString(), second.ref()["device"]["model"].GetString());
+	EXPECT_EQ(session_json, first.stringify());
+
+	EXPECT_THROW(Session("{\"country\":\"United Kingdom of Great Britain\"}"), Bad_structure);
+	EXPECT_THROW(Session("{\"country\":"), Bad_structure);
+}
+
+TEST(STRING_POOL, SET)
+{
+	Session first(session_json);
+	Session second(session_json);
+	for (int i = 0; i < 100; ++i)
+	{
+		first[country_tag{}] = "A country with a long name " + std::to_string(i % 2);
+	}
+	EXPECT_EQ("A country with a long name 1", first[country_tag{}].get());
+	second[country_tag{}] = "A country with a long name 1";
+	EXPECT_EQ(first.ref()["country"].GetString(), second.ref()["country"].GetString());
+	first[count_tag{}] = 5;
+	EXPECT_EQ(5, first[count_tag{}]);
+
+	Session empty;
+	empty[model_key{}] = "Pixel 7 Pro Max Ultra Edition";
+	EXPECT_EQ(first.ref()["device"]["model"].GetString(), empty.ref()["device"]["model"].GetString());
+}
+
+TEST(STRING_POOL, SET_CHARACTERS)
+{
+	using Labelled = Interned_root<Value_field<label_tag, const char*>>;
+
+	pool->release_unused();
+	const auto size = pool->size();
+	Labelled first("{\"label\":\"A label long enough to be pooled\"}");
+	EXPECT_EQ(size + 1, pool->size());
+	first[label_tag{}] = "Another label long enough to be pooled";
+	pool->release_unused();
+	EXPECT_EQ(size + 1, pool->size());
+	EXPECT_STREQ("Another label long enough to be pooled", first[label_tag{}].get());
+
+	Labelled second("{\"label\":\"Another label long enough to be pooled\"}");
+	EXPECT_EQ(first.ref()["label"].GetString(), second.ref()["label"].GetString());
+	second[label_tag{}] = "Short";
+	EXPECT_STREQ("Short", second[label_tag{}].get());
+}
+
+TEST(STRING_POOL, RELEASE)
+{
+	pool->release_unused();
+	const auto size = pool->size();
+	std::string clone_json;
+	{
+		Session session("{\"country\":\"Atlantis, the sunken continent\",\"device\":{\"model\":\"Nautilus submarine, first model\"},\"count\":1}");
+		const auto copy = session.clone();
+		EXPECT_LT(size, pool->size());
+		session[country_tag{}] = "Lemuria, another lost continent";
+		{
+			const Session moved(std::move(session));
+			pool->release_unused();
+			EXPECT_EQ("Lemuria, another lost continent", moved[country_tag{}].get());
+		}
+		pool->release_unused();
+		clone_json = copy.stringify();
+	}
+	EXPECT_EQ("{\"country\":\"Atlantis, the sunken continent\",\"device\":{\"model\":\"Nautilus submarine, first model\"},\"count\":1}", clone_json);
+	pool->release_unused();
+	EXPECT_EQ(size, pool->size());
+}
+
+TEST(STRING_POOL, CONCURRENT_ROOTS)
+{
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; ++t)
+	{
+		threads.emplace_back([t]
+		{
+			for (int i = 0; i < 200; ++i)
+			{
+				Session session(session_json);
+				session[country_tag{}] = "A country with a long name " + std::to_string((t + i) % 8);
+				pool->release_unused();
+				EXPECT_EQ("Pixel 7 Pro Max Ultra Edition", session[model_key{}].get());
+			}
+		});
+	}
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+}
+
+TEST(STRING_POOL, SHORT_STRINGS)
+{
+	pool->release_unused();
+	const auto size = pool->size();
+	Session session("{\"country\":\"Italy\",\"device\":{\"model\":\"Pixel\"},\"count\":1}");
+	session[model_key{}] = "Pixel 8";
+	EXPECT_EQ(size, pool->size());
+	EXPECT_EQ("{\"country\":\"Italy\",\"device\":{\"model\":\"Pixel 8\"},\"count\":1}", session.stringify());
+
+	session[model_key{}] = "Pixel 7 Pro Max Ultra Edition";
+	session[model_key{}] = "Pixel";
+	pool->release_unused();
+	EXPECT_EQ(size, pool->size());
+}
+
+TEST(STRING_POOL, MEMORY_USAGE)
+{
+	using Record = Object<device_tag, Value_field<country_tag, std::string>, Value_field<model_tag, std::string>>;
+	std::string json = "{\"records\":[";
+	for (int i = 0; i < 500; ++i)
+	{
+		json += i == 0 ? "" : ",";
+		json += "{\"country\":\"United Kingdom of Great Britain\",\"model\":\"Pixel 7 Pro Max Ultra Edition\"}";
+	}
+	json += "]}";
+
+	const Root<Array<records_tag, Record>> plain(json);
+	const Interned_root<Array<records_tag, Record>> interned(json);
+	const auto plain_usage = plain.memory_usage();
+	const auto interned_usage = interned.memory_usage();
+	EXPECT_LT(interned_usage.used, plain_usage.used);
+	EXPECT_LT(interned_usage.live, plain_usage.live);
+	EXPECT_EQ(2u, interned.document().string_interner().size());
+	EXPECT_EQ(plain.stringify(), interned.stringify());
+}
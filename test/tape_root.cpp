@@ -0,0 +1,108 @@
+#include "gtest/gtest.h"
+#include "jsontype/Root.hpp"
+#include "jsontype/Tape_root.hpp"
+#include <string>
+#include <cstdint>
+#include <iterator>
+
+using namespace jsontype;
+
+namespace
+{
+	JSONTYPE_MAKE_TAG(id);
+	JSONTYPE_MAKE_TAG(name);
+	JSONTYPE_MAKE_TAG(score);
+	JSONTYPE_MAKE_TAG(active);
+	JSONTYPE_MAKE_TAG(big);
+	JSONTYPE_MAKE_TAG(contact);
+	JSONTYPE_MAKE_TAG(address);
+	JSONTYPE_MAKE_TAG(phones);
+	JSONTYPE_MAKE_TAG(people);
+
+	using contact_address = Key<contact_tag, address_tag>;
+	using Contact = Object<contact_tag, Value_field<address_tag, std::string>, Array<phones_tag>>;
+	using Person = Tape_root<Value_field<id_tag, int>,
+			Value_field<name_tag, std::string>,
+			Value_field<score_tag, double>,
+			Value_field<active_tag, bool>,
+			Value_field<big_tag, std::uint64_t>,
+			Contact>;
+	using Dom_person = Root<Value_field<id_tag, int>,
+			Value_field<name_tag, std::string>,
+			Value_field<score_tag, double>,
+			Value_field<active_tag, bool>,
+			Value_field<big_tag, std::uint64_t>,
+			Contact>;
+
+	const std::string person_json("{\"extra\":{\"name\":\"wrong\",\"list\":[1,{\"id\":2}]},\"id\":-7,\"name\":\"Paul\","
+			"\"score\":1.5,\"active\":true,\"big\":18446744073709551615,"
+			"\"contact\":{\"phones\":[\"123\",[4],\"456\"],\"address\":\"74 Green St\"}}");
+}
+
+TEST(TAPE_ROOT, FIND)
+{
+	const Person person(person_json);
+	EXPECT_EQ(-7, person[id_tag{}].get());
+	EXPECT_EQ("Paul", person[name_tag{}].get());
+	EXPECT_EQ(1.5, person[score_tag{}].get());
+	EXPECT_TRUE(person[active_tag{}].get());
+	EXPECT_EQ(18446744073709551615ull, person[big_tag{}].get());
+	std::string address = person[contact_tag{}][address_tag{}];
+	EXPECT_EQ("74 Green St", address);
+	EXPECT_EQ(address, person[contact_address{}].get());
+	EXPECT_EQ(address, person[contact_tag{} + Key<address_tag>{}].get());
+
+	const auto phones = person[contact_tag{}][phones_tag{}];
+	EXPECT_EQ(3u, phones.size());
+	EXPECT_STREQ("123", phones[0].GetString());
+	EXPECT_EQ(1u, phones[1].Size());
+	EXPECT_STREQ("456", phones[2].GetString());
+	std::size_t count = 0;
+	for (const auto& phone : phones)
+	{
+		EXPECT_EQ(count != 1, phone.IsString());
+		++count;
+	}
+	EXPECT_EQ(3u, count);
+	EXPECT_STREQ("456", std::next(phones.begin(), 2)->GetString());
+}
+
+TEST(TAPE_ROOT, SAME_AS_DOCUMENT)
+{
+	const Person person(person_json);
+	const Dom_person dom_person(person_json);
+	EXPECT_EQ(dom_person[id_tag{}].get(), person[id_tag{}].get());
+	EXPECT_EQ(dom_person[name_tag{}].get(), person[name_tag{}].get());
+	EXPECT_EQ(dom_person[big_tag{}].get(), person[big_tag{}].get());
+	EXPECT_EQ(dom_person[contact_address{}].get(), person[contact_address{}].get());
+
+	const auto moved = std::move(person);
+	EXPECT_EQ("Paul", moved[name_tag{}].get());
+}
+
+TEST(TAPE_ROOT, STRUCTURE_CHECK)
+{
+	EXPECT_THROW(Person(std::string("")), Bad_structure);
+	EXPECT_THROW(Person(std::string("[1]")), Bad_structure);
+	EXPECT_THROW(Person(std::string("{\"id\":1")), Bad_structure);
+	EXPECT_THROW(Person(std::string("{\"id\":1,\"name\":\"a\",\"score\":1.5,\"active\":true,\"big\":1}")), Bad_structure);
+	EXPECT_THROW(Person(std::string("{\"id\":1.5,\"name\":\"a\",\"score\":1.5,\"active\":true,\"big\":1,"
+			"\"contact\":{\"address\":\"\",\"phones\":[]}}")), Bad_structure);
+	EXPECT_THROW(Person(std::string("{\"id\":1,\"name\":\"a\",\"score\":1.5,\"active\":true,\"big\":-1,"
+			"\"contact\":{\"address\":\"\",\"phones\":[]}}")), Bad_structure);
+	EXPECT_THROW(Person(std::string("{\"id\":1,\"name\":\"a\",\"score\":1.5,\"active\":true,\"big\":1,"
+			"\"contact\":{\"address\":\"\",\"phones\":{}}}")), Bad_structure);
+	EXPECT_NO_THROW(Person(std::string("{\"id\":1,\"name\":\"a\",\"score\":1.5,\"active\":true,\"big\":1,"
+			"\"contact\":{\"address\":\"\",\"phones\":[]}}")));
+}
+
+TEST(TAPE_ROOT, TYPED_ARRAY)
+{
+	using People = Tape_root<Array<people_tag, Object<contact_tag, Value_field<id_tag, int>, Array<phones_tag>>>>;
+
+	const People people(std::string("{\"people\":[{\"id\":1,\"phones\":[[2]]},{\"phones\":[],\"id\":2}]}"));
+	EXPECT_EQ(2u, people[people_tag{}].size());
+	EXPECT_THROW(People(std::string("{\"people\":[{\"id\":1,\"phones\":[]},{\"id\":2}]}")), Bad_structure);
+	EXPECT_THROW(People(std::string("{\"people\":[{\"id\":1,\"phones\":[]},[]]}")), Bad_structure);
+	EXPECT_NO_THROW(People(std::string("{\"people\":[]}")));
+}
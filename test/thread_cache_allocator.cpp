@@ -0,0 +1,114 @@
+#include "gtest/gtest.h"
+#include "jsontype/Root.hpp"
+#include "jsontype/Resolver.hpp"
+#include "jsontype/Thread_cache_allocator.hpp"
+#include <string>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <cstring>
+
+using namespace jsontype;
+
+namespace
+{
+	JSONTYPE_MAKE_TAG(name);
+	JSONTYPE_MAKE_TAG(contact);
+	JSONTYPE_MAKE_TAG(address);
+
+	using Person = Thread_cached_root<Value_field<name_tag, std::string>,
+			Object<contact_tag, Value_field<address_tag, std::string>>>;
+	using Allocator = Thread_cache_allocator<>;
+	using contact_address = Key<contact_tag, address_tag>;
+
+	const std::string person_json("{\"name\":\"Paul\",\"contact\":{\"address\":\"74 Green St\"}}");
+}
+
+TEST(THREAD_CACHE_ALLOCATOR, REUSE)
+{
+	{
+		Person person(person_json);
+		person[name_tag{}] = "Mario";
+		EXPECT_EQ("Mario", person[name_tag{}].get());
+		EXPECT_EQ("74 Green St", person[contact_address{}].get());
+		EXPECT_EQ("{\"name\":\"Mario\",\"contact\":{\"address\":\"74 Green St\"}}", person.stringify());
+	}
+	const auto retained = Allocator::retained();
+	EXPECT_GT(retained, 0u);
+	{
+		Person person(person_json);
+		EXPECT_LT(Allocator::retained(), retained);
+	}
+	EXPECT_EQ(retained, Allocator::retained());
+}
+
+TEST(THREAD_CACHE_ALLOCATOR, CLONE_AND_COMPACT)
+{
+	Person person(person_json);
+	const auto copy = person.clone();
+	person[name_tag{}] = "Mario";
+	EXPECT_EQ("Paul", copy[name_tag{}].get());
+
+	const auto used = person.memory_usage().used;
+	person.compact();
+	EXPECT_LT(person.memory_usage().used, used);
+	EXPECT_EQ(0u, person.memory_usage().lost);
+	EXPECT_EQ("{\"name\":\"Mario\",\"contact\":{\"address\":\"74 Green St\"}}", person.stringify());
+
+
+	Thread_cached_document document;
+	document.Parse(person_json.c_str());
+	const Person parsed(std::move(document));
+	EXPECT_EQ("Paul", parsed[name_tag{}].get());
+}
+
+TEST(THREAD_CACHE_ALLOCATOR, BOUNDED)
+{
+	using Small = Thread_cache_allocator<64 * 1024>;
+	Small allocator;
+	std::vector<void*> blocks;
+	for (int i = 0; i < 8; ++i)
+	{
+		blocks.push_back(allocator.Malloc(10000));
+	}
+	for (auto block : blocks)
+	{
+		Small::Free(block);
+	}
+	EXPECT_LE(Small::retained(), 64u * 1024);
+	EXPECT_GT(Small::retained(), 0u);
+
+	void* block = allocator.Malloc(100);
+	std::memset(block, 1, 100);
+	block = allocator.Realloc(block, 100, 3000);
+	EXPECT_EQ(1, static_cast<char*>(block)[99]);
+	block = allocator.Realloc(block, 3000, 20000);
+	EXPECT_EQ(1, static_cast<char*>(block)[99]);
+	Small::Free(block);
+	EXPECT_EQ(nullptr, allocator.Malloc(0));
+}
+
+TEST(THREAD_CACHE_ALLOCATOR, THREADS)
+{
+	std::vector<std::thread> workers;
+	for (int i = 0; i < 4; ++i)
+	{
+		workers.emplace_back([i]
+		{
+			Generic_resolver<Thread_cached_document, std::function<int()>> resolver;
+			resolver.add(contact_address{}, [i] { return i; });
+			for (int j = 0; j < 100; ++j)
+			{
+				Person person(person_json);
+				person[name_tag{}] = std::to_string(j);
+				EXPECT_EQ(std::to_string(j), person[name_tag{}].get());
+				EXPECT_EQ(i, resolver.scan(person_json));
+			}
+			EXPECT_GT(Allocator::retained(), 0u);
+		});
+	}
+	for (auto& worker : workers)
+	{
+		worker.join();
+	}
+}